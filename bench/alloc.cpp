@@ -0,0 +1,40 @@
+#include "bench.hpp"
+#include <front/metrics.hpp>
+#include <fstream>
+#include <malloc.h>
+#include <string>
+#include <sys/resource.h>
+
+namespace cmp {
+
+namespace bench {
+
+std::size_t allocation_count() {
+  return static_cast<std::size_t>(fnt::allocation_count());
+}
+
+void reset_peak_rss() {
+  // Memory freed by the former runs goes back to the system first.
+  ::malloc_trim(0);
+
+  // Writing 5 resets the peak RSS to the current RSS (Linux 4.0 and later).
+  auto out = std::ofstream{"/proc/self/clear_refs"};
+  out << "5";
+}
+
+std::size_t peak_rss_kb() {
+  auto status = std::ifstream{"/proc/self/status"};
+  for (std::string line; std::getline(status, line);)
+    if (line.starts_with("VmHWM:"))
+      return std::stoull(line.substr(6));
+
+  // Without procfs, only the peak of the whole process is known.
+  struct rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+
+  return static_cast<std::size_t>(usage.ru_maxrss);
+}
+
+} // namespace bench
+
+} // namespace cmp
\ No newline at end of file
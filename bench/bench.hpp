@@ -0,0 +1,83 @@
+/**
+ * @file bench.hpp
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <string>
+
+namespace cmp {
+
+namespace bench {
+
+/**
+ * Generates a program of the given number of instructions. Every mnemonic is
+ * used, and a label is defined every few instructions. Branches only refer to
+ * defined labels. The same seed always gives the same program.
+ *
+ * @param instr_count The number of instructions, labels included
+ * @param seed The seed of the generator
+ * @return std::string The program text
+ */
+std::string generate_program(std::size_t instr_count, std::uint64_t seed = 42);
+
+/**
+ * Gets the number of calls to the global operator new since the start of the
+ * program.
+ *
+ * @return std::size_t
+ */
+std::size_t allocation_count();
+
+/**
+ * Resets the peak resident set size of the process to its current RSS, where
+ * the system allows it.
+ */
+void reset_peak_rss();
+
+/**
+ * Gets the peak resident set size of the process since the last call to
+ * reset_peak_rss, or since its start if it could not be reset.
+ *
+ * @return std::size_t The peak RSS, in kilobytes
+ */
+std::size_t peak_rss_kb();
+
+/**
+ * Runs the comparisons between the current front end and its former versions
+ * on the given program, and prints their results.
+ *
+ * @param text The program text
+ * @return std::size_t The number of results differing between two versions
+ */
+std::size_t run_comparisons(std::string const &text);
+
+/**
+ * Compiles a program text into a dense program.
+ *
+ * @param text The program text
+ * @return fnt::DenseProgram
+ */
+fnt::DenseProgram compile_text(std::string const &text);
+
+/**
+ * Runs a hot loop for the given number of iterations on each interpreter, and
+ * prints the number of guest instructions they execute per second.
+ *
+ * @param iterations The number of iterations of the loop
+ * @return std::size_t The number of interpreters whose output differs
+ */
+std::size_t run_vm_comparison(std::size_t iterations);
+
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace bench
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "bench.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <front/ir.hpp>
+#include <front/pool.hpp>
+#include <front/repr.hpp>
+#include <front/source.hpp>
+#include <front/token.hpp>
+#include <malloc.h>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace bench {
+
+namespace {
+
+using namespace fnt;
+
+/**
+ * Former regex based classification, kept as a reference point.
+ */
+TokenKind legacy_tokenize_word(std::string word) {
+  auto int_lit = std::regex("^[1-9][0-9]*|0$");
+  auto reg = std::regex("^r[0-9]$");
+  auto label = std::regex("^[a-zA-Z_$][a-zA-Z_$0-9]*$");
+
+  if (detail::is_instruction(word))
+    return detail::parse_instruction(word);
+  if (std::regex_match(word, int_lit))
+    return TokenKind::INT_LIT;
+  else if (std::regex_match(word, reg))
+    return TokenKind::REGISTER;
+  else if (std::regex_match(word, label))
+    return TokenKind::LABEL;
+  else
+    return TokenKind::_UNKNOWN;
+}
+
+/**
+ * Sums the register operands of every instruction, as an analysis pass would
+ * walk the program.
+ */
+long walk_repr(ProgramRepr const &repr) {
+  long res = 0;
+
+  for (auto const &instr : repr.get_instructions()) {
+    if (auto p = dynamic_cast<LdInstr const *>(instr.get()))
+      res += p->reg_id;
+    else if (auto p = dynamic_cast<AddInstr const *>(instr.get()))
+      res += p->dst_id + p->lhs_id + p->rhs_id;
+    else if (auto p = dynamic_cast<IncInstr const *>(instr.get()))
+      res += p->reg_id;
+    else if (auto p = dynamic_cast<BnInstr const *>(instr.get()))
+      res += p->lhs_id + p->rhs_id;
+    else if (auto p = dynamic_cast<OutInstr const *>(instr.get()))
+      res += p->reg_id;
+  }
+
+  return res;
+}
+
+long walk_dense(DenseProgram const &program) {
+  long res = 0;
+
+  for (auto const &instr : program) {
+    switch (instr.opcode) {
+    case Opcode::ADD:
+      res += instr.a + instr.b + instr.c;
+      break;
+    case Opcode::BN:
+      res += instr.a + instr.b;
+      break;
+    case Opcode::LD:
+    case Opcode::INC:
+    case Opcode::OUT:
+      res += instr.a;
+      break;
+    default:
+      break;
+    }
+  }
+
+  return res;
+}
+
+/**
+ * Heap bytes held by the pointer-based representation, allocator overhead
+ * included.
+ */
+std::size_t repr_footprint(ProgramRepr const &repr) {
+  auto const &instructions = repr.get_instructions();
+  std::size_t res = instructions.capacity() * sizeof(instructions[0]);
+
+  for (auto const &instr : instructions)
+    res += malloc_usable_size(instr.get()) + sizeof(void *);
+
+  return res;
+}
+
+} // namespace
+
+std::size_t run_comparisons(std::string const &text) {
+  auto stream = std::istringstream{text};
+  auto source = TextSource::from_stream(stream);
+
+  auto start = std::chrono::steady_clock::now();
+  auto table = TokenTable::from_text_source(source).get_table();
+  double lexer_time = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  std::size_t unknown = 0;
+  for (auto const &entry : table)
+    unknown += detail::tokenize_word(entry.word) == TokenKind::_UNKNOWN;
+  double dfa_time = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  std::size_t mismatches = 0;
+  for (auto [word, kind] : table)
+    mismatches += legacy_tokenize_word(std::string{word}) != kind;
+  double regex_time = seconds_since(start);
+
+  for (auto word : {"0", "01", "10", "r", "r0", "r10", "rx", "$a", "_0", "9a",
+                    "+", "bge", "bgee", "Ld"})
+    mismatches += legacy_tokenize_word(word) != detail::tokenize_word(word);
+
+  std::printf("tokens:           %zu (%zu unknown)\n", table.size(), unknown);
+  std::printf("regex classifier: %.0f tokens/s\n", table.size() / regex_time);
+  std::printf("dfa classifier:   %.0f tokens/s\n", table.size() / dfa_time);
+  std::printf("whole lexer:      %.0f tokens/s\n", table.size() / lexer_time);
+  std::printf("token footprint:  %zu bytes (was %zu bytes plus long words)\n",
+              sizeof(TokenKind) + 2 * sizeof(std::uint32_t),
+              sizeof(std::pair<std::string, TokenKind>));
+
+  // Pools are started before timing, as a caller lexing many texts would.
+  for (std::size_t threads = 1; threads <= 32; threads *= 2) {
+    auto pool = ThreadPool{threads};
+    start = std::chrono::steady_clock::now();
+    auto parallel = TokenTable::from_text_source(source, pool).get_table();
+    double parallel_time = seconds_since(start);
+
+    mismatches += parallel.size() != table.size();
+    for (std::size_t i = 0; i < parallel.size() and i < table.size(); ++i)
+      mismatches += parallel.kind(i) != table.kind(i) or
+                    parallel.offset(i) != table.offset(i);
+
+    std::printf("lexer, %2zu threads: %.0f tokens/s\n", threads,
+                table.size() / parallel_time);
+  }
+
+  auto tokens = TokenTable::from_text_source(source);
+  auto repr = ProgramRepr::from_token_table(tokens);
+  auto dense = DenseProgram::from_program_repr(repr);
+  auto count = static_cast<double>(dense.size());
+
+  start = std::chrono::steady_clock::now();
+  long repr_sum = walk_repr(repr);
+  double repr_time = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  long dense_sum = walk_dense(dense);
+  double dense_time = seconds_since(start);
+
+  mismatches += repr_sum != dense_sum;
+
+  std::printf("instructions:     %zu\n", dense.size());
+  std::printf("repr footprint:   %.1f bytes/instr\n",
+              repr_footprint(repr) / count);
+  std::printf("dense footprint:  %.1f bytes/instr\n",
+              dense.get_code().capacity() * sizeof(DenseInstr) / count);
+  std::printf("repr walk:        %.0f instr/s\n", count / repr_time);
+  std::printf("dense walk:       %.0f instr/s\n", count / dense_time);
+
+  std::printf("mismatches:       %zu\n", mismatches);
+
+  return mismatches;
+}
+
+} // namespace bench
+
+} // namespace cmp
\ No newline at end of file
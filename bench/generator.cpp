@@ -0,0 +1,80 @@
+#include "bench.hpp"
+#include <front/mnemonic.hpp>
+#include <random>
+#include <string_view>
+
+namespace cmp {
+
+namespace bench {
+
+namespace {
+
+constexpr std::size_t LABEL_INTERVAL = 16;
+
+} // namespace
+
+std::string generate_program(std::size_t instr_count, std::uint64_t seed) {
+  auto rng = std::mt19937_64{seed};
+  auto res = std::string{};
+  auto label_count = (instr_count + LABEL_INTERVAL - 1) / LABEL_INTERVAL;
+
+  auto reg = [&] {
+    res += " r";
+    res += static_cast<char>('0' + rng() % 10);
+  };
+
+  auto label = [&] {
+    res += " l";
+    res += std::to_string(rng() % label_count);
+  };
+
+  res.reserve(instr_count * 14);
+
+  for (std::size_t i = 0; i < instr_count; ++i) {
+    if (i % LABEL_INTERVAL == 0) {
+      res += "l" + std::to_string(i / LABEL_INTERVAL) + "\n";
+      continue;
+    }
+
+    auto const &mnemonic = fnt::MNEMONICS[rng() % fnt::MNEMONICS.size()];
+    res += "  ";
+    res += mnemonic.name;
+
+    switch (mnemonic.kind) {
+    case fnt::TokenKind::BR_INST:
+      label();
+      break;
+    case fnt::TokenKind::LD_INST:
+    case fnt::TokenKind::STR_INST:
+      reg();
+      res += " " + std::to_string(rng() % 1000);
+      break;
+    case fnt::TokenKind::OUT_INST:
+    case fnt::TokenKind::INC_INST:
+    case fnt::TokenKind::DEC_INST:
+      reg();
+      break;
+    case fnt::TokenKind::ADD_INST:
+    case fnt::TokenKind::SUB_INST:
+    case fnt::TokenKind::MUL_INST:
+    case fnt::TokenKind::DIV_INST:
+      reg();
+      reg();
+      reg();
+      break;
+    default:
+      label();
+      reg();
+      reg();
+      break;
+    }
+
+    res += "\n";
+  }
+
+  return res;
+}
+
+} // namespace bench
+
+} // namespace cmp
\ No newline at end of file
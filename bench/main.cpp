@@ -0,0 +1,331 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <array>
+#include <back/object.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <front/ir.hpp>
+#include <front/repr.hpp>
+#include <front/source.hpp>
+#include <front/token.hpp>
+#include <fstream>
+#include <functional>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace cmp;
+
+struct Options {
+  std::vector<std::size_t> sizes = {1000, 10000, 100000, 1000000};
+  std::size_t repeat = 3;
+  std::size_t compare = 0;
+  std::size_t vm = 0;
+  std::string json;
+  std::string directory = "/tmp";
+  bool help = false;
+};
+
+struct PhaseResult {
+  std::string name;
+  double seconds;
+  std::size_t allocations;
+  double throughput;
+  std::string unit;
+};
+
+struct RunResult {
+  std::size_t instructions;
+  std::size_t bytes;
+  std::size_t tokens;
+  std::vector<PhaseResult> phases;
+  std::size_t peak_rss_kb;
+};
+
+void usage(std::FILE *out) {
+  std::fprintf(out, "usage: bench [--sizes n,...] [--repeat n] [--compare n] "
+                    "[--vm n] [--json path] [--dir directory]\n");
+}
+
+std::size_t parse_number(std::string const &text) {
+  try {
+    return std::stoull(text);
+  } catch (std::exception const &) {
+    throw std::runtime_error("Invalid number " + text);
+  }
+}
+
+std::vector<std::size_t> parse_sizes(std::string_view list) {
+  auto res = std::vector<std::size_t>{};
+
+  while (not list.empty()) {
+    auto end = list.find(',');
+    res.push_back(parse_number(std::string{list.substr(0, end)}));
+    list.remove_prefix(end == std::string_view::npos ? list.size() : end + 1);
+  }
+
+  return res;
+}
+
+Options parse_options(int argc, char **argv) {
+  auto res = Options{};
+
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string_view{argv[i]};
+    if (arg == "--help" or arg == "-h") {
+      res.help = true;
+      return res;
+    }
+
+    if (i + 1 >= argc)
+      throw std::runtime_error("Missing value for " + std::string{arg});
+
+    if (arg == "--sizes")
+      res.sizes = parse_sizes(argv[++i]);
+    else if (arg == "--repeat")
+      res.repeat = std::max<std::size_t>(1, parse_number(argv[++i]));
+    else if (arg == "--compare")
+      res.compare = parse_number(argv[++i]);
+    else if (arg == "--vm")
+      res.vm = parse_number(argv[++i]);
+    else if (arg == "--json")
+      res.json = argv[++i];
+    else if (arg == "--dir")
+      res.directory = argv[++i];
+    else
+      throw std::runtime_error("Unknown option " + std::string{arg});
+  }
+
+  return res;
+}
+
+/**
+ * Times a phase over several runs, keeping the fastest one. The phase returns
+ * the amount of work it did, which gives the throughput.
+ */
+PhaseResult time_phase(std::string name, std::string unit, std::size_t repeat,
+                       std::function<double()> const &phase) {
+  auto res = PhaseResult{std::move(name), 0, 0, 0, std::move(unit)};
+
+  for (std::size_t i = 0; i < repeat; ++i) {
+    auto allocations = bench::allocation_count();
+    auto start = std::chrono::steady_clock::now();
+    double work = phase();
+    double seconds = bench::seconds_since(start);
+
+    if (i == 0 or seconds < res.seconds) {
+      res.seconds = seconds;
+      res.throughput = work / seconds;
+      res.allocations = bench::allocation_count() - allocations;
+    }
+  }
+
+  return res;
+}
+
+RunResult run(Options const &options, std::size_t instr_count) {
+  auto path = options.directory + "/cmp-bench-" + std::to_string(instr_count) +
+              ".asm";
+  auto res = RunResult{instr_count, 0, 0, {}, 0};
+
+  // The generated text is freed before the peak is reset, so that the peak of
+  // each size only covers its compilation, apart from the former sizes.
+  {
+    auto text = bench::generate_program(instr_count);
+    res.bytes = text.size();
+    std::ofstream{path, std::ios::binary} << text;
+  }
+  bench::reset_peak_rss();
+
+  auto source = fnt::TextSource::from_file(path);
+  auto tokens = fnt::TokenTable::from_text_source(source);
+  res.tokens = tokens.get_table().size();
+
+  res.phases.push_back(time_phase("from_file", "MB/s", options.repeat, [&] {
+    auto other = fnt::TextSource::from_file(path);
+    return other.get_text().size() / 1e6;
+  }));
+
+  res.phases.push_back(
+      time_phase("from_text_source", "tokens/s", options.repeat, [&] {
+        return static_cast<double>(
+            fnt::TokenTable::from_text_source(source).get_table().size());
+      }));
+
+  // Word splitting alone, with each splitter the processor supports.
+  auto splitters = std::array{
+      std::pair{"split_scalar", fnt::detail::WordSplitter::SCALAR},
+      std::pair{"split_sse2", fnt::detail::WordSplitter::SSE2},
+      std::pair{"split_avx2", fnt::detail::WordSplitter::AVX2},
+  };
+  for (auto [name, splitter] : splitters) {
+    if (not fnt::detail::is_supported(splitter))
+      continue;
+
+    auto words = fnt::TokenTable::token_type{source.get_text()};
+    res.phases.push_back(time_phase(name, "MB/s", options.repeat, [&] {
+      auto text = source.get_text();
+      words.reset(text);
+      fnt::detail::extract_words(text, 0, text.size(), words, splitter);
+      return text.size() / 1e6;
+    }));
+  }
+
+  res.phases.push_back(
+      time_phase("from_token_table", "instructions/s", options.repeat, [&] {
+        return static_cast<double>(fnt::ProgramRepr::from_token_table(tokens)
+                                       .get_instructions()
+                                       .size());
+      }));
+
+  // Dense programs, built from the tokens or lowered from a representation.
+  res.phases.push_back(
+      time_phase("dense_from_tokens", "instructions/s", options.repeat, [&] {
+        return static_cast<double>(
+            fnt::DenseProgram::from_token_table(tokens).size());
+      }));
+
+  res.phases.push_back(
+      time_phase("dense_lowered", "instructions/s", options.repeat, [&] {
+        return static_cast<double>(
+            fnt::DenseProgram::from_program_repr(
+                fnt::ProgramRepr::from_token_table(tokens))
+                .size());
+      }));
+
+  res.phases.push_back(time_phase("front_end", "MB/s", options.repeat, [&] {
+    auto other = fnt::TextSource::from_file(path);
+    auto table = fnt::TokenTable::from_text_source(other);
+    fnt::ProgramRepr::from_token_table(table);
+    return other.get_text().size() / 1e6;
+  }));
+
+  // The same phases with every allocation of a compilation taken from one
+  // arena, released at once.
+  auto arena_size = source.get_text().size() * 4;
+
+  res.phases.push_back(
+      time_phase("repr_arena", "instructions/s", options.repeat, [&] {
+        auto arena = std::pmr::monotonic_buffer_resource{arena_size};
+        return static_cast<double>(
+            fnt::ProgramRepr::from_token_table(tokens, &arena)
+                .get_instructions()
+                .size());
+      }));
+
+  res.phases.push_back(
+      time_phase("front_end_arena", "MB/s", options.repeat, [&] {
+        auto arena = std::pmr::monotonic_buffer_resource{arena_size};
+        auto other = fnt::TextSource::from_file(path, &arena);
+        auto table = fnt::TokenTable::from_text_source(other, &arena);
+        fnt::ProgramRepr::from_token_table(table, &arena);
+        return other.get_text().size() / 1e6;
+      }));
+
+  auto object_path = path + ".o";
+  bck::write_object(fnt::ProgramRepr::from_token_table(tokens), object_path);
+
+  res.phases.push_back(
+      time_phase("object_map", "instructions/s", options.repeat, [&] {
+        auto object = bck::ObjectFile::map(object_path, false);
+        return static_cast<double>(object.get_code().size());
+      }));
+
+  res.phases.push_back(
+      time_phase("object_verify", "MB/s", options.repeat, [&] {
+        auto object = bck::ObjectFile::map(object_path, true);
+        return object.get_code().size_bytes() / 1e6;
+      }));
+
+  res.peak_rss_kb = bench::peak_rss_kb();
+  std::remove(path.c_str());
+  std::remove(object_path.c_str());
+
+  return res;
+}
+
+void print(RunResult const &run) {
+  std::printf("%zu instructions, %zu bytes, %zu tokens\n", run.instructions,
+              run.bytes, run.tokens);
+
+  for (auto const &phase : run.phases)
+    std::printf("  %-18s %10.3f ms %14.0f %-16s %10zu allocations\n",
+                phase.name.c_str(), phase.seconds * 1e3, phase.throughput,
+                phase.unit.c_str(), phase.allocations);
+
+  std::printf("  peak RSS           %10zu kB\n", run.peak_rss_kb);
+}
+
+void write_json(std::string const &path, std::vector<RunResult> const &runs) {
+  auto out = std::ofstream{path};
+
+  out << "{\n  \"runs\": [";
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    auto const &run = runs[i];
+
+    out << (i > 0 ? "," : "") << "\n    {\n";
+    out << "      \"instructions\": " << run.instructions << ",\n";
+    out << "      \"bytes\": " << run.bytes << ",\n";
+    out << "      \"tokens\": " << run.tokens << ",\n";
+    out << "      \"peak_rss_kb\": " << run.peak_rss_kb << ",\n";
+    out << "      \"phases\": [";
+
+    for (std::size_t j = 0; j < run.phases.size(); ++j) {
+      auto const &phase = run.phases[j];
+
+      out << (j > 0 ? "," : "") << "\n        {";
+      out << "\"name\": \"" << phase.name << "\", ";
+      out << "\"seconds\": " << phase.seconds << ", ";
+      out << "\"throughput\": " << phase.throughput << ", ";
+      out << "\"unit\": \"" << phase.unit << "\", ";
+      out << "\"allocations\": " << phase.allocations << "}";
+    }
+
+    out << "\n      ]\n    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  auto options = Options{};
+  try {
+    options = parse_options(argc, argv);
+  } catch (std::exception const &e) {
+    std::fprintf(stderr, "bench: %s\n", e.what());
+    usage(stderr);
+    return 2;
+  }
+
+  if (options.help) {
+    usage(stdout);
+    return EXIT_SUCCESS;
+  }
+
+  auto runs = std::vector<RunResult>{};
+
+  for (auto size : options.sizes) {
+    runs.push_back(run(options, size));
+    print(runs.back());
+  }
+
+  if (not options.json.empty())
+    write_json(options.json, runs);
+
+  if (options.compare > 0 and
+      bench::run_comparisons(bench::generate_program(options.compare)) > 0)
+    return EXIT_FAILURE;
+
+  if (options.vm > 0 and bench::run_vm_comparison(options.vm) > 0)
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "bench.hpp"
+#include <back/jit.hpp>
+#include <cstdio>
+#include <front/ir.hpp>
+#include <front/repr.hpp>
+#include <front/token.hpp>
+#include <sstream>
+#include <vm/profile.hpp>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace bench {
+
+namespace {
+
+/**
+ * Hot loop mixing arithmetic, increments and a conditional branch.
+ */
+std::string loop_program(std::size_t iterations) {
+  return "  ld r0 0\n"
+         "  ld r1 " +
+         std::to_string(iterations) +
+         "\n"
+         "  ld r2 3\n"
+         "loop\n"
+         "  add r3 r3 r2\n"
+         "  mul r4 r3 r2\n"
+         "  sub r5 r4 r3\n"
+         "  inc r0\n"
+         "  bn loop r0 r1\n"
+         "  out r5\n";
+}
+
+template <typename Run>
+double guest_rate(vm::Executable const &executable, Run &&run,
+                  std::string &output) {
+  auto state = vm::State{executable.memory_size()};
+  auto start = std::chrono::steady_clock::now();
+
+  run(executable, state);
+
+  double seconds = seconds_since(start);
+  output = state.output;
+
+  return state.steps / seconds;
+}
+
+} // namespace
+
+fnt::DenseProgram compile_text(std::string const &text) {
+  auto stream = std::istringstream{text};
+
+  return fnt::DenseProgram::from_program_repr(
+      fnt::ProgramRepr::from_stream(stream));
+}
+
+std::size_t run_vm_comparison(std::size_t iterations) {
+  auto program = compile_text(loop_program(iterations));
+  auto executable = vm::Executable::lower(program, vm::DEFAULT_MEMORY_SIZE,
+                                          vm::NO_FUSIONS);
+  auto switch_output = std::string{};
+  auto threaded_output = std::string{};
+  auto fused_output = std::string{};
+
+  double switch_rate = guest_rate(executable, vm::run_switch, switch_output);
+  double threaded_rate =
+      guest_rate(executable, vm::run_threaded, threaded_output);
+
+  std::printf("switch loop:      %.0f guest instr/s\n", switch_rate);
+  std::printf("threaded:         %.0f guest instr/s\n", threaded_rate);
+
+  // Trains on a short run of the program, then fuses its hottest sequences.
+  auto profile = vm::Profile{};
+  auto training = compile_text(loop_program(iterations / 100 + 1));
+  auto training_state = vm::State{};
+  vm::run_profiled(vm::Executable::lower(training), training_state, profile);
+
+  auto fusions = vm::select_fusions(profile);
+  auto fused = vm::Executable::lower(program, vm::DEFAULT_MEMORY_SIZE, fusions);
+  double fused_rate = guest_rate(fused, vm::run_threaded, fused_output);
+
+  std::printf("threaded, fused:  %.0f guest instr/s (mask 0x%x:",
+              fused_rate, fusions);
+  for (auto const &pattern : vm::FUSED_PATTERNS) {
+    if (fusions & vm::fusion_bit(pattern.id))
+      std::printf(" %.*s", static_cast<int>(pattern.name.size()),
+                  pattern.name.data());
+  }
+  std::printf(")\n");
+
+  std::size_t mismatches = (switch_output != threaded_output) +
+                           (fused_output != threaded_output);
+  if (not bck::jit_available())
+    return mismatches;
+
+  auto start = std::chrono::steady_clock::now();
+  auto jit = bck::JitProgram::compile(executable);
+  double compile_time = seconds_since(start);
+
+  auto state = vm::State{executable.memory_size()};
+  start = std::chrono::steady_clock::now();
+  jit.run(state);
+  double jit_time = seconds_since(start);
+
+  // The JIT does not count steps, the interpreters give the count.
+  auto steps = vm::State{};
+  vm::run_threaded(executable, steps);
+
+  std::printf("jit compile:      %.3f ms (%zu bytes)\n", compile_time * 1e3,
+              jit.code_size());
+  std::printf("jit:              %.0f guest instr/s\n", steps.steps / jit_time);
+
+  return mismatches + (state.output != threaded_output);
+}
+
+} // namespace bench
+
+} // namespace cmp
\ No newline at end of file
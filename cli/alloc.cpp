@@ -0,0 +1,68 @@
+#include <atomic>
+#include <cstdlib>
+#include <front/metrics.hpp>
+#include <new>
+
+// The only replacement of the global operator new of the tree. Libraries leave
+// the allocator alone, and each program counting allocations links this file,
+// which registers its counter with the metrics.
+#if defined(CMP_METRICS) || defined(CMP_COUNT_ALLOCATIONS)
+
+namespace {
+
+std::atomic<std::uint64_t> counter{0};
+
+[[maybe_unused]] bool const registered =
+    (cmp::fnt::set_allocation_counter(&counter), true);
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  counter.fetch_add(1, std::memory_order_relaxed);
+
+  if (void *p = std::malloc(size > 0 ? size : 1))
+    return p;
+
+  throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+// Memory resources allocate with an explicit alignment.
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  counter.fetch_add(1, std::memory_order_relaxed);
+
+  // The size given to aligned_alloc must be a multiple of the alignment.
+  auto align = static_cast<std::size_t>(alignment);
+  auto rounded = size > 0 ? (size + align - 1) / align * align : align;
+  if (void *p = std::aligned_alloc(align, rounded))
+    return p;
+
+  throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <driver/batch.hpp>
+#include <driver/cache.hpp>
+#include <front/metrics.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage() {
+  std::fprintf(stderr, "usage: cmpc [-j threads] [-o output_dir] "
+                       "[-c cache_dir] [-s cache_megabytes] [-m metrics_json] "
+                       "[-t trace_json] [-l] [-q] file_or_directory...\n");
+}
+
+bool write_file(std::string const &path, std::string const &content) {
+  auto out = std::ofstream{path};
+  out << content;
+
+  return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  using namespace cmp;
+
+  auto options = drv::BatchOptions{};
+  auto inputs = std::vector<std::string>{};
+  auto cache_dir = std::string{};
+  auto cache_size = drv::DEFAULT_CACHE_SIZE;
+  auto metrics_path = std::string{};
+  auto trace_path = std::string{};
+  bool quiet = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-j") == 0 and i + 1 < argc) {
+      options.thread_count = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "-o") == 0 and i + 1 < argc) {
+      options.output_dir = argv[++i];
+    } else if (std::strcmp(argv[i], "-c") == 0 and i + 1 < argc) {
+      cache_dir = argv[++i];
+    } else if (std::strcmp(argv[i], "-s") == 0 and i + 1 < argc) {
+      cache_size = std::strtoull(argv[++i], nullptr, 10) << 20;
+    } else if (std::strcmp(argv[i], "-m") == 0 and i + 1 < argc) {
+      metrics_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-t") == 0 and i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-l") == 0) {
+      options.lint = true;
+    } else if (std::strcmp(argv[i], "-q") == 0) {
+      quiet = true;
+    } else if (argv[i][0] == '-' and argv[i][1] != '\0') {
+      usage();
+      return 2;
+    } else {
+      inputs.emplace_back(argv[i]);
+    }
+  }
+
+  if (inputs.empty()) {
+    usage();
+    return 2;
+  }
+
+  if (not fnt::METRICS_ENABLED and
+      (not metrics_path.empty() or not trace_path.empty()))
+    std::fprintf(stderr, "cmpc: built without metrics, they will be empty\n");
+
+  try {
+    auto start = std::chrono::steady_clock::now();
+    auto cache = std::unique_ptr<drv::CompileCache>{};
+    if (not cache_dir.empty()) {
+      cache = std::make_unique<drv::CompileCache>(cache_dir, cache_size);
+      options.cache = cache.get();
+    }
+    auto sources = drv::collect_sources(inputs);
+    auto results = drv::compile_batch(sources, options);
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    std::size_t errors = 0;
+    std::size_t instructions = 0;
+    for (auto const &result : results) {
+      if (not result.ok) {
+        std::fprintf(stderr, "%s\n", result.diagnostic.c_str());
+        ++errors;
+      }
+      instructions += result.instruction_count;
+    }
+
+    if (not quiet)
+      std::printf("%zu files, %zu errors, %zu instructions in %.3f s\n",
+                  results.size(), errors, instructions, seconds);
+    if (not quiet and cache) {
+      auto stats = cache->stats();
+      std::printf("cache: %zu hits, %zu misses, %zu stores, %zu evictions\n",
+                  stats.hits, stats.misses, stats.stores, stats.evictions);
+    }
+
+    if (not metrics_path.empty() and
+        not write_file(metrics_path, fnt::collect_metrics().to_json()))
+      throw std::runtime_error("Metrics could not be written.");
+    if (not trace_path.empty() and
+        not write_file(trace_path, fnt::chrome_trace()))
+      throw std::runtime_error("Trace could not be written.");
+
+    return errors == 0 ? 0 : 1;
+  } catch (std::exception const &e) {
+    std::fprintf(stderr, "cmpc: %s\n", e.what());
+    return 2;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+/**
+ * @file assembly.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <front/repr.hpp>
+#include <string>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace bck {
+
+/**
+ * Emits a program as a standalone x86-64 GNU assembly file for Linux. Guest
+ * registers are kept in host registers, the memory is a static segment, and
+ * out appends to a buffer which is written when full and when the program
+ * ends. A division by zero writes a message on stderr and exits with status 1.
+ * The result assembles and links with `cc prog.s -o prog`.
+ *
+ * @param executable The program lowered for execution
+ * @return std::string The assembly source
+ */
+std::string emit_assembly(vm::Executable const &executable);
+
+/**
+ * Emits a program as a standalone x86-64 GNU assembly file for Linux.
+ *
+ * @param program The program
+ * @param memory_size The number of memory cells
+ * @return std::string The assembly source
+ */
+std::string emit_assembly(fnt::DenseProgram const &program,
+                          std::size_t memory_size = vm::DEFAULT_MEMORY_SIZE);
+
+/**
+ * Writes a program representation into an assembly file.
+ *
+ * @param repr The program representation
+ * @param path The path of the assembly file
+ * @param memory_size The number of memory cells
+ */
+void write_assembly(fnt::ProgramRepr const &repr, std::string const &path,
+                    std::size_t memory_size = vm::DEFAULT_MEMORY_SIZE);
+
+namespace detail {
+
+/**
+ * Gets the 32-bit host register holding a guest register.
+ *
+ * @param id The index of the guest register
+ * @return char const* The name of the host register, with its % prefix
+ */
+char const *host_register(std::uint8_t id);
+
+} // namespace detail
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,28 @@
+/**
+ * @file hash.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cmp {
+
+namespace bck {
+
+/**
+ * Hashes a sequence of bytes, eight of them at a time. It is not meant to
+ * resist attacks, only to detect corrupted or changed content quickly.
+ *
+ * @param data The bytes
+ * @param size The number of bytes
+ * @param seed The initial state of the hash
+ * @return std::uint64_t The hash
+ */
+std::uint64_t hash_bytes(void const *data, std::size_t size,
+                         std::uint64_t seed = 0);
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
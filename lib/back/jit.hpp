@@ -0,0 +1,86 @@
+/**
+ * @file jit.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace bck {
+
+/**
+ * Checks if the baseline JIT can run on this host (Linux on x86-64).
+ *
+ * @return true if it is available, else, false
+ */
+bool jit_available();
+
+/**
+ * Program compiled to x86-64 machine code by the baseline JIT. Each
+ * instruction is a copy of a precompiled stencil, whose operands and branch
+ * displacements are patched in place. The machine state is shared with the
+ * interpreters, except for the step count, which is not maintained.
+ */
+class JitProgram {
+public:
+  using entry_type = int (*)(std::int32_t *registers, std::int32_t *memory,
+                             vm::State *state);
+
+private:
+  void *_code = nullptr;
+  std::size_t _code_size = 0;
+  std::size_t _memory_size = vm::DEFAULT_MEMORY_SIZE;
+
+public:
+  JitProgram() = default;
+  JitProgram(JitProgram const &) = delete;
+  JitProgram(JitProgram &&other) noexcept;
+  JitProgram &operator=(JitProgram const &) = delete;
+  JitProgram &operator=(JitProgram &&other) noexcept;
+  ~JitProgram();
+
+  /**
+   * Compiles a program lowered for execution into executable memory.
+   *
+   * @param executable The lowered program
+   * @return JitProgram
+   */
+  static JitProgram compile(vm::Executable const &executable);
+
+  /**
+   * Compiles a program into executable memory.
+   *
+   * @param program The program
+   * @param memory_size The number of memory cells
+   * @return JitProgram
+   */
+  static JitProgram compile(fnt::DenseProgram const &program,
+                            std::size_t memory_size = vm::DEFAULT_MEMORY_SIZE);
+
+public:
+  /**
+   * Runs the program. Throws on a division by zero, like the interpreters.
+   *
+   * @param state The state of the machine, updated in place
+   */
+  void run(vm::State &state) const;
+
+  /**
+   * Gets the size of the generated machine code.
+   *
+   * @return std::size_t
+   */
+  std::size_t code_size() const;
+
+private:
+  void release();
+};
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * @file object.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <front/repr.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace cmp {
+
+namespace bck {
+
+inline constexpr char OBJECT_MAGIC[4] = {'C', 'M', 'P', 'O'};
+inline constexpr std::uint32_t OBJECT_VERSION = 1;
+
+/**
+ * Header of an object file. All sections follow it, each one aligned on 8
+ * bytes:
+ *
+ *   code    instr_count fixed-width instructions (fnt::DenseInstr)
+ *   labels  label_count entries (LabelEntry), indexed by label id
+ *   names   the label names, one after the other
+ *
+ * The checksum covers every byte following the header.
+ */
+struct ObjectHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t instr_count;
+  std::uint64_t label_count;
+  std::uint64_t code_offset;
+  std::uint64_t labels_offset;
+  std::uint64_t names_offset;
+  std::uint64_t names_size;
+  std::uint64_t checksum;
+};
+
+/**
+ * Label of an object file: the index of the instruction defining it, and the
+ * position of its name in the names section.
+ */
+struct LabelEntry {
+  std::uint64_t target;
+  std::uint32_t name_offset;
+  std::uint32_t name_length;
+};
+
+static_assert(sizeof(ObjectHeader) == 64, "object header layout changed");
+static_assert(sizeof(LabelEntry) == 16, "label entry layout changed");
+
+/**
+ * Encodes a program in the object format.
+ *
+ * @param program The program
+ * @return std::string The bytes of the object
+ */
+std::string encode_object(fnt::DenseProgram const &program);
+
+/**
+ * Writes a program into an object file.
+ *
+ * @param program The program
+ * @param path The path of the object file
+ */
+void write_object(fnt::DenseProgram const &program, std::string const &path);
+
+/**
+ * Writes a program representation into an object file.
+ *
+ * @param repr The program representation
+ * @param path The path of the object file
+ */
+void write_object(fnt::ProgramRepr const &repr, std::string const &path);
+
+/**
+ * Object file mapped in memory. Its sections are used in place: loading it
+ * only checks its header, in constant time. Verifying it also checks its
+ * checksum, that every instruction and label can be run as is, and reads the
+ * whole file.
+ */
+class ObjectFile {
+private:
+  void *_mapped_data = nullptr;
+  std::size_t _mapped_size = 0;
+  ObjectHeader const *_header = nullptr;
+
+public:
+  ObjectFile() = default;
+  ObjectFile(ObjectFile const &) = delete;
+  ObjectFile(ObjectFile &&other) noexcept;
+  ObjectFile &operator=(ObjectFile const &) = delete;
+  ObjectFile &operator=(ObjectFile &&other) noexcept;
+  ~ObjectFile();
+
+  /**
+   * Maps an object file in memory.
+   *
+   * @param path The path of the object file
+   * @param verify Whether the content is verified, which reads the whole file.
+   * An unverified object is trusted: running a corrupted one is undefined.
+   * @return ObjectFile
+   */
+  static ObjectFile map(std::string const &path, bool verify = true);
+
+public:
+  /**
+   * Gets the instructions, in place in the mapped file.
+   *
+   * @return std::span<fnt::DenseInstr const>
+   */
+  std::span<fnt::DenseInstr const> get_code() const;
+
+  std::size_t label_count() const;
+
+  std::string_view label_name(std::uint32_t label) const;
+
+  /**
+   * Gets the index of the instruction defining a label.
+   *
+   * @param label The label id
+   * @return std::size_t The index, or fnt::SymbolTable::NO_TARGET
+   */
+  std::size_t label_target(std::uint32_t label) const;
+
+  /**
+   * Copies the object into a dense program. Throws if two labels have the same
+   * name.
+   *
+   * @return fnt::DenseProgram
+   */
+  fnt::DenseProgram to_dense_program() const;
+
+private:
+  LabelEntry const &label_entry(std::uint32_t label) const;
+  void release();
+};
+
+namespace detail {
+
+/**
+ * Checks that a buffer holds an object, and returns its header: its sections
+ * are in bounds. Verifying it also checks its checksum, that its opcodes are
+ * known, its registers and labels exist, and each defined label targets the
+ * LABEL instruction defining it. Throws an exception otherwise.
+ *
+ * @param data The buffer, aligned on 8 bytes
+ * @param size The size of the buffer
+ * @param verify Whether the content is verified
+ * @return ObjectHeader const& The header of the object
+ */
+ObjectHeader const &check_object(void const *data, std::size_t size,
+                                 bool verify);
+
+} // namespace detail
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,97 @@
+/**
+ * @file batch.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cmp {
+
+namespace drv {
+
+class CompileCache;
+
+struct BatchOptions {
+  // Number of threads, or 0 for one per core.
+  std::size_t thread_count = 0;
+  // Directory receiving one object file per source, at the relative path of
+  // the source. No object is written if it is empty.
+  std::string output_dir;
+  // Cache of compiled programs, none if null. Its least recently used entries
+  // are evicted once the batch is done.
+  CompileCache *cache = nullptr;
+  // Only validates the sources, without exceptions, reporting every error of
+  // each one instead of the first. Neither objects nor cache entries are
+  // written.
+  bool lint = false;
+};
+
+/**
+ * Source file to compile. Its relative path is the one below the directory it
+ * was found in, or its file name if it was given directly.
+ */
+struct SourceFile {
+  std::string path;
+  std::string relative_path;
+};
+
+/**
+ * Outcome of the compilation of one source file.
+ */
+struct CompileResult {
+  std::string path;
+  std::string object_path;
+  bool ok = false;
+  // Errors of the file, one per line.
+  std::string diagnostic;
+  std::size_t instruction_count = 0;
+  // Whether the program came from the cache.
+  bool cached = false;
+};
+
+/**
+ * Lists the source files to compile. Directories are searched recursively for
+ * .asm files, listed in lexicographic order, and other paths are kept as
+ * they are.
+ *
+ * @param inputs The files and directories
+ * @return std::vector<SourceFile> The source files
+ */
+std::vector<SourceFile> collect_sources(std::vector<std::string> const &inputs);
+
+/**
+ * Compiles source files in parallel on a work-stealing thread pool. Each
+ * worker reuses its token buffer from one file to the next. Results come in
+ * the order of the sources, whatever the order files were compiled in, and a
+ * file failing to compile does not stop the others. With a cache, sources
+ * found in it are neither lexed nor parsed. Objects mirror the relative paths
+ * of the sources under the output directory. Throws if two sources would be
+ * written to the same object file.
+ *
+ * @param sources The source files
+ * @param options The options of the batch
+ * @return std::vector<CompileResult> The results, one per source
+ */
+std::vector<CompileResult> compile_batch(std::vector<SourceFile> const &sources,
+                                         BatchOptions const &options);
+
+namespace detail {
+
+/**
+ * Gets the object file of a source in an output directory.
+ *
+ * @param relative_path The relative path of the source file
+ * @param output_dir The output directory
+ * @return std::string
+ */
+std::string object_path(std::string const &relative_path,
+                        std::string const &output_dir);
+
+} // namespace detail
+
+} // namespace drv
+
+} // namespace cmp
\ No newline at end of file
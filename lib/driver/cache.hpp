@@ -0,0 +1,121 @@
+/**
+ * @file cache.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <front/ir.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cmp {
+
+namespace drv {
+
+/**
+ * Version of the compiler, part of every cache key. It must change whenever
+ * the same source may compile to a different program.
+ */
+inline constexpr std::uint32_t COMPILER_VERSION = 1;
+
+inline constexpr std::uintmax_t DEFAULT_CACHE_SIZE = std::uintmax_t{1} << 28;
+
+/**
+ * Key of a compiled program: a 128-bit hash of its source, the compiler
+ * version, the object format version and the options.
+ */
+struct CacheKey {
+  std::uint64_t low;
+  std::uint64_t high;
+
+  /**
+   * Computes the key of a source.
+   *
+   * @param source The source text
+   * @param options A value summing up the options that change the program
+   * @return CacheKey
+   */
+  static CacheKey from_source(std::string_view source,
+                              std::uint64_t options = 0);
+
+  /**
+   * Gets the key as 32 hexadecimal digits.
+   *
+   * @return std::string
+   */
+  std::string to_string() const;
+};
+
+struct CacheStats {
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t stores = 0;
+  std::size_t evictions = 0;
+};
+
+/**
+ * Content-addressed cache of compiled programs on disk, stored in the object
+ * format, one file per key. It can be shared by concurrent builds: entries
+ * are written to a temporary file then renamed, so that readers only ever see
+ * complete entries, and a corrupted entry is a miss. A hit refreshes the
+ * modification time of its entry, which eviction uses as the last use.
+ */
+class CompileCache {
+private:
+  std::filesystem::path _dir;
+  std::uintmax_t _max_size;
+  std::atomic<std::size_t> _hits = 0;
+  std::atomic<std::size_t> _misses = 0;
+  std::atomic<std::size_t> _stores = 0;
+  std::atomic<std::size_t> _evictions = 0;
+
+public:
+  /**
+   * Opens a cache, creating its directory if needed.
+   *
+   * @param dir The directory of the cache
+   * @param max_size The size over which entries are evicted, in bytes
+   */
+  explicit CompileCache(std::string const &dir,
+                        std::uintmax_t max_size = DEFAULT_CACHE_SIZE);
+
+  /**
+   * Looks a program up. Entries are checked as any object file, so a corrupted
+   * or forged one is a miss, and it is replaced once compiled again.
+   *
+   * @param key The key of the program
+   * @return std::optional<fnt::DenseProgram> The program, or nothing on a miss
+   */
+  std::optional<fnt::DenseProgram> load(CacheKey const &key);
+
+  /**
+   * Stores a program, replacing any entry with the same key. On failure, the
+   * temporary file written is removed and the entry is left as it was.
+   *
+   * @param key The key of the program
+   * @param program The program
+   */
+  void store(CacheKey const &key, fnt::DenseProgram const &program);
+
+  /**
+   * Removes the least recently used entries until the cache fits in its
+   * maximum size, along with temporary files left by interrupted builds.
+   *
+   * @return std::size_t The number of evicted entries
+   */
+  std::size_t evict();
+
+  CacheStats stats() const;
+
+private:
+  std::filesystem::path entry_path(CacheKey const &key) const;
+};
+
+} // namespace drv
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+ * @file diagnostic.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * An error found in a program, located at one of its tokens. Lines and columns
+ * start at 1, and columns count bytes.
+ */
+struct Diagnostic {
+  std::size_t token;
+  std::size_t offset;
+  std::size_t line;
+  std::size_t column;
+  std::string message;
+
+  /**
+   * Formats the diagnostic as "path:line:column: message".
+   *
+   * @param path The path of the source file
+   * @return std::string
+   */
+  std::string to_string(std::string_view path) const;
+};
+
+/**
+ * Error held by an Expected, to tell it apart from a value.
+ */
+template <typename E> struct Unexpected {
+  E error;
+};
+
+/**
+ * Either a value or an error, as std::expected, for code reporting errors
+ * without exceptions. Accessing the alternative it does not hold is undefined.
+ */
+template <typename T, typename E> class Expected {
+private:
+  std::variant<T, E> _storage;
+
+public:
+  Expected(T value) : _storage(std::in_place_index<0>, std::move(value)) {}
+
+  Expected(Unexpected<E> error)
+      : _storage(std::in_place_index<1>, std::move(error.error)) {}
+
+  bool has_value() const noexcept { return _storage.index() == 0; }
+
+  explicit operator bool() const noexcept { return has_value(); }
+
+  T &value() & { return *std::get_if<0>(&_storage); }
+
+  T const &value() const & { return *std::get_if<0>(&_storage); }
+
+  T &&value() && { return std::move(*std::get_if<0>(&_storage)); }
+
+  E &error() & { return *std::get_if<1>(&_storage); }
+
+  E const &error() const & { return *std::get_if<1>(&_storage); }
+
+  E &&error() && { return std::move(*std::get_if<1>(&_storage)); }
+
+  T &operator*() & { return value(); }
+
+  T const &operator*() const & { return value(); }
+
+  T *operator->() { return &value(); }
+
+  T const *operator->() const { return &value(); }
+};
+
+namespace detail {
+
+/**
+ * Sorts diagnostics by token, and computes their lines and columns from their
+ * offsets in a single pass over the text.
+ *
+ * @param text The source text
+ * @param diagnostics The diagnostics, whose offsets are set
+ */
+void locate_diagnostics(std::string_view text,
+                        std::vector<Diagnostic> &diagnostics);
+
+} // namespace detail
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
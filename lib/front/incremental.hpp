@@ -0,0 +1,144 @@
+/**
+ * @file incremental.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/repr.hpp>
+#include <front/symbol.hpp>
+#include <front/token.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Replacement of a range of the program text. The range starts at the given
+ * column of the given line and spans length bytes, line breaks included, so it
+ * may cover several lines.
+ */
+struct TextEdit {
+  std::size_t line;
+  std::size_t column;
+  std::size_t length;
+  std::string_view text;
+};
+
+/**
+ * Program kept ready for small edits, as in watch mode. The text, the tokens
+ * and the instructions are stored line by line, so an edit only re-lexes and
+ * re-parses the lines it touches. Lines are replaced in place, and only an edit
+ * adding or removing lines shifts the following ones.
+ *
+ * Labels are counted over the label tokens of all lines, and a name no line
+ * mentions anymore is released from the symbols, so its id is reused.
+ *
+ * Each instruction must fit on one line, with all its operands. The whole
+ * program parser accepts operands on the following lines, but here such an
+ * instruction makes its line fail with "Unexpected end of line.".
+ */
+class IncrementalProgram {
+public:
+  struct Line {
+    // Index of the line in the program.
+    std::size_t number;
+    std::string text;
+    TokenTable::token_type tokens;
+    ProgramRepr::instr_sequence_type instructions;
+    std::string error;
+    // Labels the line defines, kept while a previous line defines one of them
+    // and the line is rejected.
+    std::vector<std::uint32_t> labels;
+  };
+
+  using line_sequence_type = std::vector<std::unique_ptr<Line>>;
+
+private:
+  line_sequence_type _lines;
+  SymbolTable _symbols;
+  std::vector<Line *> _label_lines;
+  // Lines defining each label, accepted or not.
+  std::vector<std::vector<Line *>> _definers;
+  // Label tokens naming each label, over all lines.
+  std::vector<std::uint32_t> _label_uses;
+
+public:
+  /**
+   * Constructs an incremental program from a whole program text.
+   *
+   * @param text The program text
+   * @return IncrementalProgram
+   */
+  static IncrementalProgram from_text(std::string_view text);
+
+public:
+  /**
+   * Applies an edit to the program. Only the lines covered by the edited range
+   * are lexed and parsed again. A line which cannot be parsed keeps its text
+   * and tokens, has no instruction, and gets an error message.
+   *
+   * A label is defined by its first definition, as when the whole program is
+   * parsed, and lines defining it again are rejected. When the edit adds or
+   * removes a definition, only the lines defining the same labels are checked
+   * again, and a rejected line which now defines its labels is parsed anew.
+   *
+   * @param edit The edit
+   */
+  void edit(TextEdit const &edit);
+
+  /**
+   * Gets the lines of the program, each one with its tokens and instructions.
+   *
+   * @return line_sequence_type const&
+   */
+  line_sequence_type const &get_lines() const;
+
+  /**
+   * Gets the labels of the program. Label targets are not recorded as
+   * instruction indices here, since they move with every edit, use
+   * get_label_line instead. Ids of labels no line names anymore are released.
+   *
+   * @return SymbolTable const&
+   */
+  SymbolTable const &get_symbols() const;
+
+  /**
+   * Gets the line defining a label.
+   *
+   * @param id The label id
+   * @return Line const* The line, or nullptr if the label is not defined
+   */
+  Line const *get_label_line(std::uint32_t id) const;
+
+  /**
+   * Checks if any line of the program could not be parsed.
+   *
+   * @return true if a line has an error, else, false
+   */
+  bool has_errors() const;
+
+  /**
+   * Rebuilds the whole program text.
+   *
+   * @return std::string
+   */
+  std::string get_text() const;
+
+private:
+  std::unique_ptr<Line> make_line(std::string text, std::size_t number);
+  void parse_line(Line &line);
+  void remove_line(Line const &line, std::vector<std::uint32_t> &freed);
+  void release_labels(Line const &line);
+  bool can_define_labels(Line const &line) const;
+  void settle_labels(std::vector<Line *> pending);
+};
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
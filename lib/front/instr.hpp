@@ -10,26 +10,90 @@
 
 #pragma once
 
+#include "front/symbol.hpp"
 #include "front/token.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
 
 namespace cmp {
 
 namespace fnt {
 
+struct DenseInstr;
+
 /**
  * Instruction base for the represxentation of a program
  */
 struct Instr {
   virtual ~Instr() = default;
+
+  /**
+   * Gets the dense form of the instruction. Overrides are defined in ir.cpp,
+   * along with the dense representation.
+   *
+   * @return DenseInstr
+   */
+  virtual DenseInstr lower() const = 0;
+};
+
+/**
+ * Deleter of instructions allocated from a memory resource. The resource needs
+ * the size and the alignment of the instruction to free it, and the base class
+ * does not know them, so the deleter keeps them along with the resource.
+ */
+class InstrDeleter {
+private:
+  std::pmr::memory_resource *_resource = nullptr;
+  std::size_t _size = 0;
+  std::size_t _alignment = 0;
+
+public:
+  InstrDeleter() = default;
+
+  InstrDeleter(std::pmr::memory_resource *resource, std::size_t size,
+               std::size_t alignment)
+      : _resource(resource), _size(size), _alignment(alignment) {}
+
+  void operator()(Instr *instr) const noexcept {
+    instr->~Instr();
+    _resource->deallocate(instr, _size, _alignment);
+  }
 };
 
+using InstrPtr = std::unique_ptr<Instr, InstrDeleter>;
+
+/**
+ * Constructs an instruction in memory taken from a resource.
+ *
+ * @tparam T The type of the instruction
+ * @param resource The memory resource
+ * @param args The arguments of the constructor
+ * @return InstrPtr
+ */
+template <typename T, typename... Args>
+InstrPtr allocate_instr(std::pmr::memory_resource *resource, Args &&...args) {
+  void *memory = resource->allocate(sizeof(T), alignof(T));
+
+  try {
+    auto instr = ::new (memory) T(std::forward<Args>(args)...);
+    return InstrPtr{instr, InstrDeleter{resource, sizeof(T), alignof(T)}};
+  } catch (...) {
+    resource->deallocate(memory, sizeof(T), alignof(T));
+    throw;
+  }
+}
+
 /**
  * Branch instruction
  */
 struct BrInstr : public Instr {
-  std::string label;
-  BrInstr(std::string_view l);
+  std::uint32_t label_id;
+  BrInstr(std::uint32_t l);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -39,6 +103,7 @@ struct LdInstr : public Instr {
   int reg_id;
   int value;
   LdInstr(std::string_view reg, std::string_view val);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -48,6 +113,7 @@ struct StrInstr : public Instr {
   int reg_id;
   int memory_cell;
   StrInstr(std::string_view reg, std::string_view mem);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -56,6 +122,7 @@ struct StrInstr : public Instr {
 struct OutInstr : public Instr {
   int reg_id;
   OutInstr(std::string_view reg);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -66,6 +133,7 @@ struct AddInstr : public Instr {
   int lhs_id;
   int rhs_id;
   AddInstr(std::string_view dst, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -76,6 +144,7 @@ struct SubInstr : public Instr {
   int lhs_id;
   int rhs_id;
   SubInstr(std::string_view dst, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -86,6 +155,7 @@ struct MulInstr : public Instr {
   int lhs_id;
   int rhs_id;
   MulInstr(std::string_view dst, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -96,6 +166,7 @@ struct DivInstr : public Instr {
   int lhs_id;
   int rhs_id;
   DivInstr(std::string_view dst, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -104,6 +175,7 @@ struct DivInstr : public Instr {
 struct IncInstr : public Instr {
   int reg_id;
   IncInstr(std::string_view reg);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -112,16 +184,18 @@ struct IncInstr : public Instr {
 struct DecInstr : public Instr {
   int reg_id;
   DecInstr(std::string_view reg);
+  DenseInstr lower() const override;
 };
 
 /**
  * Branch if not equal instruction
  */
 struct BnInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BnInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BnInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
@@ -129,115 +203,129 @@ struct BnInstr : public Instr {
  *
  */
 struct BeInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BeInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BeInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
  * Branch if greater instruction
  */
 struct BgInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BgInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BgInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
  * Branch if smaller instruction
  */
 struct BsInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BsInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BsInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
  * Branch if greater or equal instruction
  */
 struct BgeInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BgeInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BgeInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
  * Branch if smaller or equal instruction
  */
 struct BseInstr : public Instr {
-  std::string label;
+  std::uint32_t label_id;
   int lhs_id;
   int rhs_id;
-  BseInstr(std::string_view l, std::string_view lhs, std::string_view rhs);
+  BseInstr(std::uint32_t l, std::string_view lhs, std::string_view rhs);
+  DenseInstr lower() const override;
 };
 
 /**
  * Label representation
  */
 struct Label : public Instr {
-  std::string label;
-  Label(std::string_view l);
+  std::uint32_t label_id;
+  Label(std::uint32_t l);
+  DenseInstr lower() const override;
 };
 
 /*
  * All functions below are made to create a representation of an instruction or
- * a label from the initial token table
+ * a label from the initial token table. Label names are interned in the given
+ * symbol table, and instructions are allocated from the given resource.
  */
 
-std::unique_ptr<Instr> make_br_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_br_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_ld_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_ld_instr(TokenTable::token_type const &table, size_t &index,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_str_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_str_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_out_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_out_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_add_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_add_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_sub_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_sub_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_mul_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_mul_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_div_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_div_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_inc_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_inc_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_dec_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_dec_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_be_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_be_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_bn_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_bn_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_bg_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_bg_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_bs_instr(TokenTable::token_type const &table,
-                                     size_t &index);
+InstrPtr make_bs_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_bge_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_bge_instr(TokenTable::token_type const &table, size_t &index,
+                        SymbolTable &symbols,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_bse_instr(TokenTable::token_type const &table,
-                                      size_t &index);
+InstrPtr make_bse_instr(TokenTable::token_type const &table, size_t &index,
+                        SymbolTable &symbols,
+                        std::pmr::memory_resource *resource);
 
-std::unique_ptr<Instr> make_label(TokenTable::token_type const &table,
-                                  size_t &index);
+InstrPtr make_label(TokenTable::token_type const &table, size_t &index,
+                    SymbolTable &symbols, std::pmr::memory_resource *resource);
 
 namespace detail {
 
@@ -249,6 +337,17 @@ namespace detail {
  */
 int get_register_id(std::string_view reg);
 
+/**
+ * Checks that an instruction is followed by enough tokens for its operands. If
+ * not, throw an exception.
+ *
+ * @param table The tokens
+ * @param index The index of the instruction
+ * @param count The number of operands of the instruction
+ */
+void check_operand_count(TokenTable::token_type const &table,
+                         std::size_t index, std::size_t count);
+
 } // namespace detail
 
 } // namespace fnt
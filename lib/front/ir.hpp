@@ -0,0 +1,177 @@
+/**
+ * @file ir.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/repr.hpp>
+#include <front/symbol.hpp>
+#include <front/token.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Operation performed by a dense instruction
+ */
+enum class Opcode : std::uint8_t {
+  BR,
+  LD,
+  STR,
+  OUT,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  INC,
+  DEC,
+  BE,
+  BN,
+  BG,
+  BS,
+  BGE,
+  BSE,
+  LABEL,
+};
+
+/**
+ * Fixed-width instruction record. Operands are laid out as follows:
+ *
+ *   br  <label>             imm = label
+ *   ld  <a> <imm>           str <a> <imm>
+ *   out <a>, inc <a>, dec <a>
+ *   add <a> <b> <c>         a is the destination (same for sub, mul and div)
+ *   be  <label> <a> <b>     imm = label (same for bn, bg, bs, bge and bse)
+ *   <label>                 imm = label
+ *
+ * Labels are the integer ids given by the symbol table of the program.
+ */
+struct DenseInstr {
+  Opcode opcode;
+  std::uint8_t a = 0;
+  std::uint8_t b = 0;
+  std::uint8_t c = 0;
+  std::int32_t imm = 0;
+
+  std::uint32_t label() const { return static_cast<std::uint32_t>(imm); }
+};
+
+static_assert(sizeof(DenseInstr) == 8, "dense instructions must stay compact");
+
+/**
+ * Checks if the given opcode is a branch, conditional or not.
+ *
+ * @param opcode The given opcode
+ * @return true if it is a branch, else, false
+ */
+bool is_branch(Opcode opcode);
+
+/**
+ * Contiguous representation of a program, meant to be walked by the passes
+ * following the front end without any pointer chasing nor virtual dispatch.
+ */
+class DenseProgram {
+public:
+  using code_type = std::vector<DenseInstr>;
+  using const_iterator = code_type::const_iterator;
+
+private:
+  code_type _code;
+  SymbolTable _symbols;
+
+public:
+  /**
+   * Constructs a dense program from a token table, without building any
+   * program representation first. It accepts and rejects the same programs as
+   * ProgramRepr::from_token_table, with the same errors, and gives the same
+   * program as lowering its result.
+   *
+   * @param table The token table
+   * @return DenseProgram
+   */
+  static DenseProgram from_token_table(TokenTable const &table);
+
+  /**
+   * Lowers a program representation into a dense program.
+   *
+   * @param repr The program representation
+   * @return DenseProgram
+   */
+  static DenseProgram from_program_repr(ProgramRepr const &repr);
+
+  /**
+   * Constructs a dense program from its instructions and its labels.
+   *
+   * @param code The instructions
+   * @param symbols The labels, with their targets in the instructions
+   * @return DenseProgram
+   */
+  static DenseProgram from_code(code_type code, SymbolTable symbols);
+
+public:
+  std::size_t size() const { return _code.size(); }
+
+  bool empty() const { return _code.empty(); }
+
+  DenseInstr const &operator[](std::size_t index) const { return _code[index]; }
+
+  const_iterator begin() const { return _code.begin(); }
+
+  const_iterator end() const { return _code.end(); }
+
+  /**
+   * Gets the instructions as a contiguous sequence.
+   *
+   * @return code_type const&
+   */
+  code_type const &get_code() const;
+
+  /**
+   * Gets the labels of the program. Since lowering keeps instructions in place,
+   * label targets are also indices in the dense program.
+   *
+   * @return SymbolTable const&
+   */
+  SymbolTable const &get_symbols() const;
+
+  /**
+   * Gets the number of distinct labels of the program.
+   *
+   * @return std::size_t
+   */
+  std::size_t label_count() const;
+
+  /**
+   * Gets the name of a label from its id.
+   *
+   * @param label The label id
+   * @return std::string_view The name of the label
+   */
+  std::string_view label_name(std::uint32_t label) const;
+};
+
+namespace detail {
+
+/**
+ * Makes the dense instruction or label starting at the given index, and moves
+ * the index past it. Label names are interned in the given symbol table.
+ *
+ * @param table The tokens
+ * @param index The index of the first token of the instruction
+ * @param symbols The symbol table receiving the labels
+ * @return DenseInstr
+ */
+DenseInstr make_dense_instr(TokenTable::token_type const &table,
+                            std::size_t &index, SymbolTable &symbols);
+
+} // namespace detail
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
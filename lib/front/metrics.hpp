@@ -0,0 +1,261 @@
+/**
+ * @file metrics.hpp
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Whether the front end records metrics. They are only compiled in when
+ * CMP_METRICS is defined; otherwise, timers and counters are empty and cost
+ * nothing.
+ */
+#ifdef CMP_METRICS
+inline constexpr bool METRICS_ENABLED = true;
+#else
+inline constexpr bool METRICS_ENABLED = false;
+#endif
+
+/**
+ * Timed phases of the front end. Classification happens while words are
+ * extracted, so its time is also part of the word extraction time. It is
+ * sampled, and only timed when words are extracted from a whole text.
+ */
+enum class Phase : std::uint8_t {
+  FILE_READ,
+  WORD_EXTRACTION,
+  CLASSIFICATION,
+  INSTRUCTION_BUILDING,
+};
+
+inline constexpr std::size_t PHASE_COUNT = 4;
+
+enum class Counter : std::uint8_t {
+  BYTES,
+  TOKENS,
+  INSTRUCTIONS,
+};
+
+inline constexpr std::size_t COUNTER_COUNT = 3;
+
+struct PhaseMetrics {
+  std::uint64_t nanoseconds = 0;
+  std::uint64_t calls = 0;
+};
+
+/**
+ * Metrics of every thread since the start of the program or the last reset.
+ */
+struct Metrics {
+  std::array<PhaseMetrics, PHASE_COUNT> phases{};
+  std::uint64_t bytes = 0;
+  std::uint64_t tokens = 0;
+  std::uint64_t instructions = 0;
+  // Calls to the global operator new, from any code, if the program counts
+  // them (see set_allocation_counter).
+  std::uint64_t allocations = 0;
+
+  PhaseMetrics const &operator[](Phase phase) const {
+    return phases[static_cast<std::size_t>(phase)];
+  }
+
+  /**
+   * Gets the metrics as a JSON object, times being in nanoseconds.
+   *
+   * @return std::string
+   */
+  std::string to_json() const;
+};
+
+/**
+ * Gets the name of a phase, as used in the JSON and trace outputs.
+ *
+ * @param phase The phase
+ * @return char const*
+ */
+char const *phase_name(Phase phase);
+
+/**
+ * Sums the metrics of every thread.
+ *
+ * @return Metrics
+ */
+Metrics collect_metrics();
+
+/**
+ * Sets every metric back to zero and forgets the recorded trace events.
+ */
+void reset_metrics();
+
+/**
+ * Makes the metrics read allocations from a counter of the program. Libraries
+ * do not replace the global operator new, so a program wanting allocation
+ * counts replaces it in one of its own translation units, and registers the
+ * counter it increments there.
+ *
+ * @param counter The counter, which must live as long as the program
+ */
+void set_allocation_counter(std::atomic<std::uint64_t> const *counter);
+
+/**
+ * Gets the number of calls to the global operator new since the start of the
+ * program, or zero if the program does not count them.
+ *
+ * @return std::uint64_t
+ */
+std::uint64_t allocation_count();
+
+/**
+ * Gets the recorded phases as a Chrome trace-event JSON document, loadable in
+ * chrome://tracing or Perfetto. Classification is left out: there is one per
+ * word, so it is only given as a total.
+ *
+ * @return std::string
+ */
+std::string chrome_trace();
+
+namespace detail {
+
+/**
+ * Reads a clock cheap enough to time each word. Its ticks are converted to
+ * nanoseconds when metrics are collected.
+ *
+ * @return std::uint64_t
+ */
+inline std::uint64_t read_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+void record_phase(Phase phase, std::uint64_t start, std::uint64_t end);
+
+/**
+ * Adds the time of a phase run many times, extrapolated from some timed runs,
+ * without any trace event. The time taken by reading the clock is left out
+ * of each timed run.
+ *
+ * @param phase The phase
+ * @param ticks The total time of the timed runs, in ticks
+ * @param samples The number of timed runs
+ * @param runs The number of runs
+ */
+void record_sampled_phase(Phase phase, std::uint64_t ticks,
+                          std::uint64_t samples, std::uint64_t runs);
+
+void record_count(Counter counter, std::uint64_t value);
+
+} // namespace detail
+
+#ifdef CMP_METRICS
+
+/**
+ * Times a phase, from its construction to its destruction.
+ */
+class PhaseTimer {
+private:
+  Phase _phase;
+  std::uint64_t _start;
+
+public:
+  explicit PhaseTimer(Phase phase)
+      : _phase(phase), _start(detail::read_ticks()) {}
+
+  PhaseTimer(PhaseTimer const &) = delete;
+  PhaseTimer &operator=(PhaseTimer const &) = delete;
+
+  ~PhaseTimer() { detail::record_phase(_phase, _start, detail::read_ticks()); }
+};
+
+/**
+ * Times a phase run many times in a row, such as the classification of each
+ * word. Timing every run would cost more than the run itself, so only one run
+ * in SAMPLE_INTERVAL is timed. The total is extrapolated from them and
+ * recorded once, at destruction.
+ */
+class SampledTimer {
+public:
+  static constexpr std::uint64_t SAMPLE_INTERVAL = 16;
+
+private:
+  Phase _phase;
+  std::uint64_t _runs = 0;
+  std::uint64_t _samples = 0;
+  std::uint64_t _ticks = 0;
+
+public:
+  explicit SampledTimer(Phase phase) : _phase(phase) {}
+
+  SampledTimer(SampledTimer const &) = delete;
+  SampledTimer &operator=(SampledTimer const &) = delete;
+
+  ~SampledTimer() {
+    if (_samples > 0)
+      detail::record_sampled_phase(_phase, _ticks, _samples, _runs);
+  }
+
+  /**
+   * Runs the phase once.
+   *
+   * @param run The phase
+   * @return The result of the phase
+   */
+  template <typename F> decltype(auto) time(F &&run) {
+    if (_runs++ % SAMPLE_INTERVAL != 0)
+      return run();
+
+    auto start = detail::read_ticks();
+    decltype(auto) res = run();
+    _ticks += detail::read_ticks() - start;
+    ++_samples;
+
+    return res;
+  }
+};
+
+inline void count(Counter counter, std::uint64_t value) {
+  detail::record_count(counter, value);
+}
+
+#else
+
+class [[maybe_unused]] PhaseTimer {
+public:
+  explicit PhaseTimer(Phase) {}
+
+  PhaseTimer(PhaseTimer const &) = delete;
+  PhaseTimer &operator=(PhaseTimer const &) = delete;
+};
+
+class [[maybe_unused]] SampledTimer {
+public:
+  explicit SampledTimer(Phase) {}
+
+  SampledTimer(SampledTimer const &) = delete;
+  SampledTimer &operator=(SampledTimer const &) = delete;
+
+  template <typename F> decltype(auto) time(F &&run) { return run(); }
+};
+
+inline void count(Counter, std::uint64_t) {}
+
+#endif
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
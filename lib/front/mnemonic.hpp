@@ -0,0 +1,226 @@
+/**
+ * @file mnemonic.hpp
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <front/token.hpp>
+#include <string_view>
+
+namespace cmp {
+
+namespace fnt {
+
+inline constexpr std::size_t MAX_OPERANDS = 3;
+
+/**
+ * An instruction word, its meaning, the number and the kinds of the operands
+ * following it, and its syntax as shown in error messages
+ */
+struct Mnemonic {
+  std::string_view name;
+  TokenKind kind;
+  std::uint8_t operand_count;
+  std::array<TokenKind, MAX_OPERANDS> operands;
+  std::string_view usage;
+};
+
+/**
+ * Every instruction of the language. Adding an opcode only requires adding its
+ * mnemonic here, the lookup table below is derived from it at compile time.
+ */
+inline constexpr auto MNEMONICS = std::array{
+    Mnemonic{"br", TokenKind::BR_INST, 1, {TokenKind::LABEL}, "br <label>"},
+    Mnemonic{"ld", TokenKind::LD_INST, 2,
+             {TokenKind::REGISTER, TokenKind::INT_LIT},
+             "ld <register> <value>"},
+    Mnemonic{"str", TokenKind::STR_INST, 2,
+             {TokenKind::REGISTER, TokenKind::INT_LIT},
+             "str <register> <memory>"},
+    Mnemonic{"out", TokenKind::OUT_INST, 1, {TokenKind::REGISTER},
+             "out <register>"},
+    Mnemonic{"add", TokenKind::ADD_INST, 3,
+             {TokenKind::REGISTER, TokenKind::REGISTER, TokenKind::REGISTER},
+             "add <destination> <lhs> <rhs>"},
+    Mnemonic{"sub", TokenKind::SUB_INST, 3,
+             {TokenKind::REGISTER, TokenKind::REGISTER, TokenKind::REGISTER},
+             "sub <destination> <lhs> <rhs>"},
+    Mnemonic{"mul", TokenKind::MUL_INST, 3,
+             {TokenKind::REGISTER, TokenKind::REGISTER, TokenKind::REGISTER},
+             "mul <destination> <lhs> <rhs>"},
+    Mnemonic{"div", TokenKind::DIV_INST, 3,
+             {TokenKind::REGISTER, TokenKind::REGISTER, TokenKind::REGISTER},
+             "div <destination> <lhs> <rhs>"},
+    Mnemonic{"inc", TokenKind::INC_INST, 1, {TokenKind::REGISTER},
+             "inc <register>"},
+    Mnemonic{"dec", TokenKind::DEC_INST, 1, {TokenKind::REGISTER},
+             "dec <register>"},
+    Mnemonic{"be", TokenKind::BE_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "be <label> <lhs> <rhs>"},
+    Mnemonic{"bn", TokenKind::BN_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "bn <label> <lhs> <rhs>"},
+    Mnemonic{"bg", TokenKind::BG_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "bg <label> <lhs> <rhs>"},
+    Mnemonic{"bs", TokenKind::BS_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "bs <label> <lhs> <rhs>"},
+    Mnemonic{"bge", TokenKind::BGE_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "bge <label> <lhs> <rhs>"},
+    Mnemonic{"bse", TokenKind::BSE_INST, 3,
+             {TokenKind::LABEL, TokenKind::REGISTER, TokenKind::REGISTER},
+             "bse <label> <lhs> <rhs>"},
+};
+
+namespace detail {
+
+inline constexpr std::size_t MNEMONIC_HASH_BITS = 6;
+inline constexpr std::size_t MNEMONIC_SLOT_COUNT = 1 << MNEMONIC_HASH_BITS;
+
+/**
+ * Hashes every character of a word (FNV-1a). Only words whose length lies
+ * between the shortest and the longest mnemonic are hashed, so it reads a few
+ * characters at most.
+ *
+ * @param word The given word
+ * @return std::uint32_t The key of the word
+ */
+constexpr std::uint32_t mnemonic_key(std::string_view word) {
+  std::uint32_t res = 0x811c9dc5;
+
+  for (char c : word)
+    res = (res ^ static_cast<unsigned char>(c)) * 0x01000193;
+
+  return res;
+}
+
+constexpr std::size_t mnemonic_slot(std::uint32_t key, std::uint32_t seed) {
+  return (key * seed) >> (32 - MNEMONIC_HASH_BITS);
+}
+
+inline constexpr std::uint32_t MAX_MNEMONIC_SEED_TRIES = 1 << 16;
+
+/**
+ * Searches a multiplier for which every mnemonic falls in its own slot.
+ *
+ * @return std::uint32_t The multiplier of the perfect hash, or zero if there
+ * is none among the tried ones
+ */
+constexpr std::uint32_t find_mnemonic_seed() {
+  for (std::uint32_t i = 0; i < MAX_MNEMONIC_SEED_TRIES; ++i) {
+    std::uint32_t seed = 0x9e3779b1 + 2 * i;
+    auto used = std::array<bool, MNEMONIC_SLOT_COUNT>{};
+    bool collision = false;
+
+    for (auto const &mnemonic : MNEMONICS) {
+      auto slot = mnemonic_slot(mnemonic_key(mnemonic.name), seed);
+      collision = collision or used[slot];
+      used[slot] = true;
+    }
+
+    if (not collision)
+      return seed;
+  }
+
+  return 0;
+}
+
+inline constexpr std::uint32_t MNEMONIC_SEED = find_mnemonic_seed();
+
+static_assert(MNEMONIC_SEED != 0,
+              "no perfect hash of the mnemonics, raise MNEMONIC_HASH_BITS");
+
+/**
+ * Slot table of the perfect hash: index of the mnemonic in MNEMONICS plus one,
+ * or zero for an empty slot.
+ */
+inline constexpr auto MNEMONIC_SLOTS = [] {
+  auto res = std::array<std::uint8_t, MNEMONIC_SLOT_COUNT>{};
+
+  for (std::size_t i = 0; i < MNEMONICS.size(); ++i)
+    res[mnemonic_slot(mnemonic_key(MNEMONICS[i].name), MNEMONIC_SEED)] =
+        static_cast<std::uint8_t>(i + 1);
+
+  return res;
+}();
+
+inline constexpr auto MNEMONIC_LENGTHS = [] {
+  auto res = std::array<std::size_t, 2>{MNEMONICS[0].name.size(),
+                                        MNEMONICS[0].name.size()};
+
+  for (auto const &mnemonic : MNEMONICS) {
+    res[0] = mnemonic.name.size() < res[0] ? mnemonic.name.size() : res[0];
+    res[1] = mnemonic.name.size() > res[1] ? mnemonic.name.size() : res[1];
+  }
+
+  return res;
+}();
+
+} // namespace detail
+
+/**
+ * Looks a word up in the mnemonic table.
+ *
+ * @param word The given word
+ * @return TokenKind The meaning of the instruction, or _UNKNOWN if the word
+ * is not an instruction
+ */
+constexpr TokenKind find_mnemonic(std::string_view word) {
+  if (word.size() < detail::MNEMONIC_LENGTHS[0] or
+      word.size() > detail::MNEMONIC_LENGTHS[1])
+    return TokenKind::_UNKNOWN;
+
+  auto slot = detail::MNEMONIC_SLOTS[detail::mnemonic_slot(
+      detail::mnemonic_key(word), detail::MNEMONIC_SEED)];
+
+  if (slot == 0 or MNEMONICS[slot - 1].name != word)
+    return TokenKind::_UNKNOWN;
+
+  return MNEMONICS[slot - 1].kind;
+}
+
+/**
+ * Gets the mnemonic of an instruction.
+ *
+ * @param kind The meaning of the instruction
+ * @return Mnemonic const* The mnemonic, or nullptr if the kind is not an
+ * instruction
+ */
+constexpr Mnemonic const *mnemonic_of(TokenKind kind) {
+  for (auto const &mnemonic : MNEMONICS)
+    if (mnemonic.kind == kind)
+      return &mnemonic;
+
+  return nullptr;
+}
+
+/**
+ * Gets the number of operands of an instruction.
+ *
+ * @param kind The meaning of the instruction
+ * @return std::size_t The number of operands following the instruction word
+ */
+constexpr std::size_t operand_count(TokenKind kind) {
+  auto mnemonic = mnemonic_of(kind);
+
+  return mnemonic != nullptr ? mnemonic->operand_count : 0;
+}
+
+static_assert(
+    [] {
+      for (auto const &mnemonic : MNEMONICS)
+        if (find_mnemonic(mnemonic.name) != mnemonic.kind)
+          return false;
+      return true;
+    }(),
+    "every mnemonic must be found in its own slot");
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,86 @@
+/**
+ * @file pool.hpp
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Pool of threads with one task queue per worker. A worker takes its own
+ * tasks from the back of its queue, and steals from the front of the others
+ * once it has nothing left, so that uneven tasks keep every thread busy.
+ *
+ * Tasks are given the index of the worker running them, so that they can use
+ * per-worker buffers. They must not throw.
+ */
+class ThreadPool {
+public:
+  using task_type = std::function<void(std::size_t worker)>;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _workers;
+  std::atomic<std::size_t> _queued = 0;
+  std::atomic<std::size_t> _pending = 0;
+  std::atomic<std::size_t> _next = 0;
+  bool _stopping = false;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+
+public:
+  /**
+   * Starts the workers.
+   *
+   * @param thread_count The number of workers, or 0 for one per core
+   */
+  explicit ThreadPool(std::size_t thread_count = 0);
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  /**
+   * Runs the remaining tasks, then stops the workers.
+   */
+  ~ThreadPool();
+
+  /**
+   * Queues a task, on the workers in turn.
+   *
+   * @param task The task
+   */
+  void submit(task_type task);
+
+  /**
+   * Waits until every submitted task has run.
+   */
+  void wait();
+
+  std::size_t size() const { return _workers.size(); }
+
+private:
+  void work(std::size_t index);
+
+  bool take(std::size_t index, task_type &task);
+};
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -10,9 +10,14 @@
 
 #pragma once
 
+#include <front/diagnostic.hpp>
 #include <front/instr.hpp>
+#include <front/stream.hpp>
+#include <front/symbol.hpp>
 #include <front/token.hpp>
+#include <istream>
 #include <memory>
+#include <memory_resource>
 #include <vector>
 
 namespace cmp {
@@ -21,23 +26,73 @@ namespace fnt {
 
 /**
  * Serves as a kind of AST, but it is not a tree. It's just an abstract
- * representation of then program
+ * representation of then program. Its instructions, their sequence and its
+ * labels are all allocated from one memory resource, so that a compilation
+ * can use an arena and free everything at once. The resource must outlive the
+ * representation.
  */
 class ProgramRepr {
 public:
-  using instr_sequence_type = std::vector<std::unique_ptr<Instr>>;
+  using instr_sequence_type = std::pmr::vector<InstrPtr>;
 
 private:
   instr_sequence_type _instr_sequence;
+  SymbolTable _symbols;
 
 public:
+  ProgramRepr() = default;
+
+  /**
+   * Constructs an empty program representation allocating from a resource.
+   *
+   * @param resource The memory resource
+   */
+  explicit ProgramRepr(std::pmr::memory_resource *resource);
+
   /**
    * Constructs a program representation from a token table.
    *
    * @param table The initial token table
+   * @param resource The memory resource of the representation
    * @return ProgramRepr
    */
-  static ProgramRepr from_token_table(TokenTable const &table);
+  static ProgramRepr
+  from_token_table(TokenTable const &table,
+                   std::pmr::memory_resource *resource =
+                       std::pmr::get_default_resource());
+
+  /**
+   * Constructs a program representation from a token table without throwing
+   * on invalid programs. Every error is collected in one pass: after each
+   * one, parsing resumes at the next instruction word or at the next label
+   * starting a line. Branches to undefined labels are reported too, although
+   * the representation allows them.
+   *
+   * @param table The initial token table
+   * @param resource The memory resource of the representation
+   * @return Expected<ProgramRepr, std::vector<Diagnostic>> The representation,
+   * or every diagnostic of the program in the order of the tokens
+   */
+  static Expected<ProgramRepr, std::vector<Diagnostic>>
+  try_from_token_table(TokenTable const &table,
+                       std::pmr::memory_resource *resource =
+                           std::pmr::get_default_resource());
+
+  /**
+   * Constructs a program representation by reading a source stream chunk by
+   * chunk. No text source nor token table is built, so the memory used besides
+   * the representation is bounded by the chunk size.
+   *
+   * @param input The source stream
+   * @param chunk_size The number of bytes read at once
+   * @param resource The memory resource of the representation
+   * @return ProgramRepr
+   */
+  static ProgramRepr
+  from_stream(std::istream &input,
+              std::size_t chunk_size = StreamLexer::DEFAULT_CHUNK_SIZE,
+              std::pmr::memory_resource *resource =
+                  std::pmr::get_default_resource());
 
 public:
   /**
@@ -47,6 +102,14 @@ public:
    * @return instr_sequence_type const&
    */
   instr_sequence_type const &get_instructions() const;
+
+  /**
+   * Gets the labels of the program, along with the index of the instruction
+   * defining each of them.
+   *
+   * @return SymbolTable const&
+   */
+  SymbolTable const &get_symbols() const;
 };
 
 namespace detail {
@@ -55,9 +118,37 @@ namespace detail {
  * Gathers tokens to make instructions for the abstract representation.
  *
  * @param table The token table
+ * @param symbols The symbol table receiving the labels
+ * @param resource The memory resource of the instructions and their sequence
  * @return ProgramRepr::instr_sequence_type
  */
-ProgramRepr::instr_sequence_type gather_tokens(TokenTable const &table);
+ProgramRepr::instr_sequence_type
+gather_tokens(TokenTable const &table, SymbolTable &symbols,
+              std::pmr::memory_resource *resource);
+
+/**
+ * Appends an instruction to a sequence. If it is a label, its index is
+ * recorded in the symbol table.
+ *
+ * @param sequence The instruction sequence
+ * @param instr The instruction
+ * @param symbols The symbol table
+ */
+void push_instr(ProgramRepr::instr_sequence_type &sequence, InstrPtr instr,
+                SymbolTable &symbols);
+
+/**
+ * Makes the instruction or the label starting at the given index, and moves
+ * the index past it.
+ *
+ * @param table The tokens
+ * @param index The index of the first token of the instruction
+ * @param symbols The symbol table receiving the labels
+ * @param resource The memory resource of the instruction
+ * @return InstrPtr
+ */
+InstrPtr make_instr(TokenTable::token_type const &table, size_t &index,
+                    SymbolTable &symbols, std::pmr::memory_resource *resource);
 
 } // namespace detail
 
@@ -10,9 +10,12 @@
 
 #pragma once
 
+#include <cstddef>
 #include <exception>
 #include <fstream>
 #include <ios>
+#include <istream>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -24,44 +27,95 @@ namespace fnt {
 namespace detail {
 
 /**
- * Tries to open the file at the given path. If it fails, throw an exception.
+ * Reads the whole content left in a file descriptor, resuming interrupted
+ * reads. If it fails, throw an exception.
  *
- * @param filename The path to the file to open
- * @return std::ifstream The input stream to the opened file
+ * @param fd The file descriptor, which is not closed
+ * @param resource The memory resource of the text
+ * @return std::pmr::string The content of the file
  */
-std::ifstream try_open_source_file(std::string filename);
+std::pmr::string read_source_file(
+    int fd,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 /**
- * Converts a source file into a text containing the whole program.
+ * Converts a source stream into a text containing the whole program.
  *
- * @param file_handler The source file
- * @return std::string The whole program as a text
+ * @param file_handler The source stream
+ * @param resource The memory resource of the text
+ * @return std::pmr::string The whole program as a text
  */
-std::string convert_source_to_text(std::ifstream &file_handler);
+std::pmr::string convert_source_to_text(
+    std::istream &file_handler,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 } // namespace detail
 
+/**
+ * Handler of the raw program text. Regular files are memory-mapped read-only
+ * and exposed as is, other inputs (pipes, standard input...) are copied into a
+ * buffer owned by the handler, allocated from a memory resource.
+ */
 class TextSource {
 private:
-  std::string _text_source;
+  std::pmr::string _text_source;
+  char const *_mapped_data = nullptr;
+  std::size_t _mapped_size = 0;
 
 public:
+  TextSource() = default;
+  TextSource(TextSource const &) = delete;
+  TextSource(TextSource &&other) noexcept;
+  TextSource &operator=(TextSource const &) = delete;
+  TextSource &operator=(TextSource &&other) noexcept;
+  ~TextSource();
+
   /**
-   * Constructs a text source from a source file. The content of the file is put
-   * in a buffer handled by TextSource.
+   * Constructs a text source from a source file. Regular files are mapped in
+   * memory without any copy, otherwise the content of the file is read once,
+   * as is, into a buffer handled by TextSource. The path "-" designates the
+   * standard input.
    *
    * @param filename The path to the source file
+   * @param resource The memory resource of the buffer, if one is needed
+   * @return TextSource The handler of the source text
+   */
+  static TextSource from_file(std::string filename,
+                              std::pmr::memory_resource *resource =
+                                  std::pmr::get_default_resource());
+
+  /**
+   * Constructs a text source by reading the whole given stream into a buffer
+   * handled by TextSource.
+   *
+   * @param stream The source stream
+   * @param resource The memory resource of the buffer
    * @return TextSource The handler of the source text
    */
-  static TextSource from_file(std::string filename);
+  static TextSource from_stream(std::istream &stream,
+                                std::pmr::memory_resource *resource =
+                                    std::pmr::get_default_resource());
 
 public:
   /**
-   * Gets a reference to the raw source text.
+   * Gets a view on the raw source text. Lines are kept separated by their
+   * original line breaks.
    *
-   * @return std::string const&
+   * @return std::string_view
    */
-  std::string const &get_text() const;
+  std::string_view get_text() const;
+
+  /**
+   * Checks if the source text is directly mapped from the source file.
+   *
+   * @return true if it is memory-mapped, else, false
+   */
+  bool is_mapped() const;
+
+private:
+  explicit TextSource(std::pmr::memory_resource *resource);
+
+  void release();
 };
 
 } // namespace fnt
@@ -0,0 +1,58 @@
+/**
+ * @file stream.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <front/token.hpp>
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Lexer reading its input by fixed-size chunks. Tokens are produced on demand,
+ * so the memory it holds is bounded by the size of a chunk and of the longest
+ * word, whatever the size of the input.
+ */
+class StreamLexer {
+public:
+  static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
+private:
+  std::istream &_input;
+  std::vector<char> _chunk;
+  std::size_t _position = 0;
+  std::size_t _end = 0;
+  std::string _spanning_word;
+
+public:
+  /**
+   * Constructs a lexer over the given stream.
+   *
+   * @param input The source stream
+   * @param chunk_size The number of bytes read at once
+   */
+  explicit StreamLexer(std::istream &input,
+                       std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+  /**
+   * Reads the next token of the input. Its word is only valid until the next
+   * call.
+   *
+   * @return std::optional<Token> The token, or nothing at the end of the input
+   */
+  std::optional<Token> next();
+
+private:
+  bool refill();
+};
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,120 @@
+/**
+ * @file symbol.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+/**
+ * Interns label names. Each distinct name is stored once and designated by a
+ * dense id, in order of first appearance. The table also keeps the index of the
+ * instruction defining each label, so branch targets are resolved in constant
+ * time. Everything is allocated from one memory resource, and copies use the
+ * default one.
+ *
+ * Ids of released names are given again to the next new names, so a table
+ * following an edited program does not grow with every label ever typed.
+ */
+class SymbolTable {
+public:
+  static constexpr std::size_t NO_TARGET =
+      std::numeric_limits<std::size_t>::max();
+
+private:
+  std::pmr::deque<std::pmr::string> _names;
+  std::pmr::unordered_map<std::string_view, std::uint32_t> _ids;
+  std::pmr::vector<std::size_t> _targets;
+  std::pmr::vector<std::uint32_t> _released;
+
+public:
+  SymbolTable() = default;
+
+  /**
+   * Constructs an empty table allocating from a resource.
+   *
+   * @param resource The memory resource, which must outlive the table
+   */
+  explicit SymbolTable(std::pmr::memory_resource *resource);
+
+  SymbolTable(SymbolTable const &other);
+  SymbolTable(SymbolTable &&other) noexcept = default;
+  SymbolTable &operator=(SymbolTable const &other);
+
+  /**
+   * Moves a table. If both tables do not use the same resource, the names
+   * cannot be moved, so they are copied.
+   *
+   * @param other The moved table
+   * @return SymbolTable&
+   */
+  SymbolTable &operator=(SymbolTable &&other);
+
+  /**
+   * Gets the id of a label name, giving it a new one on its first appearance.
+   *
+   * @param name The label name
+   * @return std::uint32_t The id of the label
+   */
+  std::uint32_t intern(std::string_view name);
+
+  /**
+   * Gets the id of an already interned label name.
+   *
+   * @param name The label name
+   * @return std::optional<std::uint32_t> The id, or nothing if it is unknown
+   */
+  std::optional<std::uint32_t> find(std::string_view name) const;
+
+  /**
+   * Records the index of the instruction defining a label. A label can only be
+   * defined once.
+   *
+   * @param id The label id
+   * @param index The index of the label in the instruction sequence
+   */
+  void define(std::uint32_t id, std::size_t index);
+
+  /**
+   * Gets the index of the instruction defining a label.
+   *
+   * @param id The label id
+   * @return std::size_t The index, or NO_TARGET if the label is never defined
+   */
+  std::size_t target(std::uint32_t id) const { return _targets[id]; }
+
+  /**
+   * Forgets a label name and its definition. Its id is given to the next new
+   * name.
+   *
+   * @param id The label id
+   */
+  void release(std::uint32_t id);
+
+  std::string_view name(std::uint32_t id) const { return _names[id]; }
+
+  /**
+   * Gets the number of ids handed out, released ones included. Every id is
+   * below it.
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const { return _names.size(); }
+};
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
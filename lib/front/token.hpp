@@ -10,8 +10,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <front/pool.hpp>
 #include <front/source.hpp>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -22,7 +27,7 @@ namespace fnt {
 /**
  * All kinds of tokens are there
  */
-enum class TokenKind {
+enum class TokenKind : std::uint8_t {
   INT_LIT = 1,
   STR_LIT = 2,
   BR_INST = 3,
@@ -46,6 +51,116 @@ enum class TokenKind {
   _UNKNOWN,
 };
 
+/**
+ * A token, as handed out by a token array: a view on its word in the source
+ * text, and its meaning.
+ */
+struct Token {
+  std::string_view word;
+  TokenKind kind;
+};
+
+/**
+ * Compact sequence of tokens. Words are never copied: each token only keeps
+ * its meaning, its offset and its length in the source text, and each of these
+ * fields is stored in its own array. The arrays are allocated from a memory
+ * resource, which must outlive them.
+ */
+class TokenArray {
+private:
+  std::string_view _source;
+  std::pmr::vector<TokenKind> _kinds;
+  std::pmr::vector<std::uint32_t> _offsets;
+  std::pmr::vector<std::uint32_t> _lengths;
+
+public:
+  class const_iterator {
+  private:
+    TokenArray const *_array;
+    std::size_t _index;
+
+  public:
+    const_iterator(TokenArray const *array, std::size_t index)
+        : _array(array), _index(index) {}
+
+    Token operator*() const { return (*_array)[_index]; }
+
+    const_iterator &operator++() {
+      ++_index;
+      return *this;
+    }
+
+    bool operator==(const_iterator const &other) const {
+      return _index == other._index;
+    }
+  };
+
+public:
+  TokenArray() = default;
+
+  /**
+   * Constructs an empty token array whose words are taken from the given text.
+   *
+   * @param source The source text, which must outlive the array
+   * @param resource The memory resource of the array
+   */
+  explicit TokenArray(std::string_view source,
+                      std::pmr::memory_resource *resource =
+                          std::pmr::get_default_resource());
+
+  /**
+   * Appends a token to the array.
+   *
+   * @param kind The meaning of the token
+   * @param offset The position of its word in the source text
+   * @param length The length of its word
+   */
+  void push_back(TokenKind kind, std::size_t offset, std::size_t length);
+
+  /**
+   * Appends the tokens of another array sharing the same source text.
+   *
+   * @param other The other array
+   */
+  void append(TokenArray const &other);
+
+  void reserve(std::size_t count);
+
+  /**
+   * Removes every token, keeping the allocated storage, and makes the array
+   * refer to another source text.
+   *
+   * @param source The new source text, which must outlive the array
+   */
+  void reset(std::string_view source);
+
+  std::size_t size() const { return _kinds.size(); }
+
+  bool empty() const { return _kinds.empty(); }
+
+  Token operator[](std::size_t index) const {
+    return {word(index), _kinds[index]};
+  }
+
+  TokenKind kind(std::size_t index) const { return _kinds[index]; }
+
+  std::string_view word(std::size_t index) const {
+    return _source.substr(_offsets[index], _lengths[index]);
+  }
+
+  std::size_t offset(std::size_t index) const { return _offsets[index]; }
+
+  std::string_view source() const { return _source; }
+
+  std::pmr::memory_resource *resource() const {
+    return _kinds.get_allocator().resource();
+  }
+
+  const_iterator begin() const { return {this, 0}; }
+
+  const_iterator end() const { return {this, size()}; }
+};
+
 /**
  * It represents the set of "words" in the program. Each word has a special
  * meaning, and this class associates each of them with there respective
@@ -53,38 +168,86 @@ enum class TokenKind {
  */
 class TokenTable {
 public:
-  using token_type = std::vector<std::pair<std::string, TokenKind>>;
+  using token_type = TokenArray;
 
 private:
   token_type _token_table;
 
+  explicit TokenTable(token_type &&tokens);
+
 public:
+  TokenTable() = default;
+
   /**
-   * Constructs a token table from a raw text program.
+   * Constructs a token table from a raw text program. The table refers to the
+   * words of the text source, so the latter must outlive it.
    *
    * @param text_source The raw text program
    * @return TokenTable
    */
   static TokenTable from_text_source(TextSource const &text_source);
 
+  /**
+   * Constructs a token table from a raw text program, allocating the tokens
+   * from a memory resource.
+   *
+   * @param text_source The raw text program
+   * @param resource The memory resource, which must outlive the table
+   * @return TokenTable
+   */
+  static TokenTable from_text_source(TextSource const &text_source,
+                                     std::pmr::memory_resource *resource);
+
+  /**
+   * Constructs a token table from a raw text program, lexing it on the
+   * workers of a pool. The text is split into chunks at line breaks, one per
+   * worker but none smaller than detail::MIN_CHUNK_SIZE, and the tokens of
+   * each chunk are put back in order, so the result is the same as with a
+   * single thread. A text too small for two chunks is lexed by the caller.
+   *
+   * The call waits for every task of the pool, so it must not be made from
+   * one of them.
+   *
+   * @param text_source The raw text program
+   * @param pool The pool lexing the chunks
+   * @return TokenTable
+   */
+  static TokenTable from_text_source(TextSource const &text_source,
+                                     ThreadPool &pool);
+
+  /**
+   * Constructs a token table from a raw text program, storing the tokens in
+   * a reused array, so that lexing many files does not allocate every time.
+   *
+   * @param text_source The raw text program
+   * @param buffer The array to reuse, as given back by release
+   * @return TokenTable
+   */
+  static TokenTable from_text_source(TextSource const &text_source,
+                                     token_type &&buffer);
+
 public:
   /**
-   * Gets tokens as a vector of the couple (word, meaning).
+   * Gets tokens as a sequence of couples (word, meaning).
    *
    * @return token_type const&
    */
   token_type const &get_table() const;
+
+  /**
+   * Gives the tokens away, leaving the table empty, so that their storage can
+   * be reused.
+   *
+   * @return token_type
+   */
+  token_type release();
 };
 
 namespace detail {
 
-/**
- * Removes white spaces at the left side of a string.
- *
- * @param word The given string to trim
- * @return std::string The trimmed string
- */
-std::string left_trim(std::string const &word);
+// Smallest chunk of text lexed by a worker of a pool: below it, handing the
+// chunk over and stitching its tokens back cost more than lexing it.
+constexpr std::size_t MIN_CHUNK_SIZE = std::size_t{1} << 18;
 
 /**
  * Checks if the given character is a white character (return, space, tab...)
@@ -98,18 +261,83 @@ bool is_white_character(char c);
  * Decomposes a given text program to extract words from it.
  *
  * @param text_source The text program
- * @return TokenTable::token_type A vector of couples (word, meaning)
+ * @return TokenTable::token_type The sequence of couples (word, meaning)
  */
 TokenTable::token_type
 extract_words_from_text_source(TextSource const &text_source);
 
 /**
- * Associates a correct meaning with the given word
+ * Decomposes a given text program to extract words from it, on the workers
+ * of a pool.
+ *
+ * @param text_source The text program
+ * @param pool The pool lexing the chunks
+ * @return TokenTable::token_type The sequence of couples (word, meaning)
+ */
+TokenTable::token_type
+extract_words_from_text_source(TextSource const &text_source,
+                               ThreadPool &pool);
+
+/**
+ * Ways of finding word boundaries. The SIMD ones test 16 or 32 bytes at once,
+ * and turn each block of 64 bytes into a mask of its white characters, whose
+ * bit changes are the word boundaries. They all give the same words.
+ */
+enum class WordSplitter : std::uint8_t {
+  SCALAR,
+  SSE2,
+  AVX2,
+};
+
+/**
+ * Checks if the processor running the program can use a word splitter.
+ *
+ * @param splitter The word splitter
+ * @return true if it can, else, false
+ */
+bool is_supported(WordSplitter splitter);
+
+/**
+ * Gets the fastest word splitter the processor supports. It is detected
+ * once, at the first call.
+ *
+ * @return WordSplitter
+ */
+WordSplitter best_word_splitter();
+
+/**
+ * Extracts the words lying in a range of a text, and appends them to a token
+ * array. The range must not start nor end in the middle of a word.
+ *
+ * @param text The whole text
+ * @param begin The start of the range
+ * @param end The end of the range
+ * @param res The token array receiving the words
+ */
+void extract_words(std::string_view text, std::size_t begin, std::size_t end,
+                   TokenTable::token_type &res);
+
+/**
+ * Extracts the words lying in a range of a text with the given splitter,
+ * which must be supported.
+ *
+ * @param text The whole text
+ * @param begin The start of the range
+ * @param end The end of the range
+ * @param res The token array receiving the words
+ * @param splitter The word splitter
+ */
+void extract_words(std::string_view text, std::size_t begin, std::size_t end,
+                   TokenTable::token_type &res, WordSplitter splitter);
+
+/**
+ * Associates a correct meaning with the given word. The word is classified
+ * in a single pass over its characters, without any allocation.
  *
  * @param word The word
  * @return TokenKind The meaning of the word
  */
-TokenKind tokenize_word(std::string word);
+TokenKind tokenize_word(std::string_view word);
 
 /**
  * Checks if the given word is an instruction (add, ld, br...)
@@ -117,7 +345,7 @@ TokenKind tokenize_word(std::string word);
  * @param word The given word
  * @return true if it is an instruction, else, false
  */
-bool is_instruction(std::string word);
+bool is_instruction(std::string_view word);
 
 /**
  * Parses an instruction word to associate it with its instruction meaning
@@ -125,7 +353,7 @@ bool is_instruction(std::string word);
  * @param word The given word
  * @return TokenKind The associated meaning
  */
-TokenKind parse_instruction(std::string word);
+TokenKind parse_instruction(std::string_view word);
 
 } // namespace detail
 
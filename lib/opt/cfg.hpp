@@ -0,0 +1,157 @@
+/**
+ * @file cfg.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <limits>
+#include <vector>
+
+namespace cmp {
+
+namespace opt {
+
+inline constexpr std::uint32_t NO_BLOCK =
+    std::numeric_limits<std::uint32_t>::max();
+inline constexpr std::uint32_t NO_LOOP =
+    std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Maximal straight-line sequence of instructions [begin, end) of a dense
+ * program. A block starts at the program entry, at a label or after a branch,
+ * and only its last instruction may be a branch.
+ *
+ * Successors hold the taken target of the final branch first, then the
+ * fall-through block, without duplicates. The last block of the program has
+ * no fall-through: running past it ends the program.
+ */
+struct BasicBlock {
+  std::size_t begin;
+  std::size_t end;
+  std::vector<std::uint32_t> successors;
+  std::vector<std::uint32_t> predecessors;
+};
+
+/**
+ * Natural loop: the header and every block reaching one of its back edges
+ * without going through the header. Loops sharing a header are merged. Blocks
+ * only lists the blocks whose innermost loop is this one, header first.
+ */
+struct Loop {
+  std::uint32_t header;
+  std::uint32_t parent = NO_LOOP;
+  std::uint32_t depth = 1;
+  std::vector<std::uint32_t> latches;
+  std::vector<std::uint32_t> blocks;
+};
+
+/**
+ * Control-flow graph of a dense program, with its dominator tree and its loop
+ * nesting forest. Block 0 is the entry. Every analysis runs in near-linear
+ * time in the size of the program.
+ */
+class ControlFlowGraph {
+private:
+  std::vector<BasicBlock> _blocks;
+  std::vector<std::uint32_t> _reverse_postorder;
+  std::vector<std::uint32_t> _order;
+  std::vector<std::uint32_t> _idom;
+  std::vector<std::uint32_t> _preorder;
+  std::vector<std::uint32_t> _postorder;
+  std::vector<Loop> _loops;
+  std::vector<std::uint32_t> _loop_of;
+
+public:
+  /**
+   * Builds the control-flow graph of a program. Throws if a branch refers to
+   * an undefined label.
+   *
+   * @param program The program
+   * @return ControlFlowGraph
+   */
+  static ControlFlowGraph from_dense_program(fnt::DenseProgram const &program);
+
+public:
+  std::size_t size() const { return _blocks.size(); }
+
+  bool empty() const { return _blocks.empty(); }
+
+  BasicBlock const &operator[](std::size_t block) const {
+    return _blocks[block];
+  }
+
+  std::vector<BasicBlock> const &get_blocks() const;
+
+  /**
+   * Gets the blocks reachable from the entry, in reverse postorder: a block
+   * comes before its successors, except along back edges.
+   *
+   * @return std::vector<std::uint32_t> const&
+   */
+  std::vector<std::uint32_t> const &reverse_postorder() const;
+
+  bool is_reachable(std::uint32_t block) const;
+
+  /**
+   * Gets the immediate dominator of a block. The entry and unreachable blocks
+   * have none.
+   *
+   * @param block The block
+   * @return std::uint32_t The immediate dominator, or NO_BLOCK
+   */
+  std::uint32_t immediate_dominator(std::uint32_t block) const;
+
+  /**
+   * Checks if every path from the entry to a block goes through another one,
+   * in constant time. A block dominates itself.
+   *
+   * @param dominator The dominating block
+   * @param block The dominated block
+   * @return true if it dominates, else, false
+   */
+  bool dominates(std::uint32_t dominator, std::uint32_t block) const;
+
+  /**
+   * Gets the natural loops, inner loops after the loops enclosing them.
+   *
+   * @return std::vector<Loop> const&
+   */
+  std::vector<Loop> const &get_loops() const;
+
+  /**
+   * Gets the innermost loop containing a block.
+   *
+   * @param block The block
+   * @return std::uint32_t The loop, or NO_LOOP
+   */
+  std::uint32_t loop_of(std::uint32_t block) const;
+
+  /**
+   * Checks if a block belongs to a loop or to one of its inner loops.
+   *
+   * @param loop The loop
+   * @param block The block
+   * @return true if the loop contains the block, else, false
+   */
+  bool contains(std::uint32_t loop, std::uint32_t block) const;
+
+  /**
+   * Gets the number of loops containing a block.
+   *
+   * @param block The block
+   * @return std::uint32_t
+   */
+  std::uint32_t loop_depth(std::uint32_t block) const;
+
+private:
+  void compute_order();
+  void compute_dominators();
+  void compute_loops();
+};
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * @file constant.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <front/ir.hpp>
+
+namespace cmp {
+
+namespace opt {
+
+/**
+ * Counts of what constant propagation changed in a program.
+ */
+struct ConstantStats {
+  std::size_t instructions_before = 0;
+  std::size_t instructions_after = 0;
+  std::size_t folded = 0;
+  std::size_t redundant_removed = 0;
+  std::size_t branches_taken = 0;
+  std::size_t branches_removed = 0;
+  std::size_t unreachable_removed = 0;
+};
+
+/**
+ * Conditional constant propagation. Registers start at zero, and their values
+ * are tracked through the control-flow graph along the edges found to be
+ * executable only, so that branches decided at compile time also decide which
+ * code is reached.
+ *
+ * Operations with known results become ld, writes of a value already in the
+ * register are removed, conditional branches with known outcomes become br or
+ * are removed, and unreachable blocks are deleted. A division by zero is never
+ * folded, so that it still fails at runtime.
+ *
+ * @param program The program
+ * @param stats The counts of changes, filled by the pass
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram propagate_constants(fnt::DenseProgram const &program,
+                                      ConstantStats &stats);
+
+/**
+ * Conditional constant propagation, without statistics.
+ *
+ * @param program The program
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram propagate_constants(fnt::DenseProgram const &program);
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,45 @@
+/**
+ * @file dead.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <front/ir.hpp>
+
+namespace cmp {
+
+namespace opt {
+
+/**
+ * Counts of what dead write elimination changed in a program.
+ */
+struct DeadCodeStats {
+  std::size_t instructions_before = 0;
+  std::size_t instructions_after = 0;
+  std::size_t removed = 0;
+};
+
+/**
+ * Removes the instructions whose only effect is to write a register that is
+ * never read afterwards, according to liveness. Divisions are kept, since
+ * they may fail.
+ *
+ * @param program The program
+ * @param stats The counts of changes, filled by the pass
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram eliminate_dead_code(fnt::DenseProgram const &program,
+                                      DeadCodeStats &stats);
+
+/**
+ * Removes dead writes, without statistics.
+ *
+ * @param program The program
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram eliminate_dead_code(fnt::DenseProgram const &program);
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
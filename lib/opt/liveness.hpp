@@ -0,0 +1,86 @@
+/**
+ * @file liveness.hpp
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <front/ir.hpp>
+#include <opt/cfg.hpp>
+#include <vector>
+
+namespace cmp {
+
+namespace opt {
+
+/**
+ * Set of registers, one bit per register.
+ */
+using RegisterSet = std::uint16_t;
+
+/**
+ * Registers live at the boundaries of each block. A register is live if its
+ * value may still be read by an instruction which has an effect. Reads by
+ * writes that are themselves dead do not count, so that whole chains of dead
+ * writes are found at once. Nothing is live at the end of the program.
+ */
+class Liveness {
+private:
+  std::vector<RegisterSet> _live_in;
+  std::vector<RegisterSet> _live_out;
+
+public:
+  /**
+   * Computes liveness with a backward dataflow over the blocks.
+   *
+   * @param program The program
+   * @param cfg The control-flow graph of the program
+   * @return Liveness
+   */
+  static Liveness from_cfg(fnt::DenseProgram const &program,
+                           ControlFlowGraph const &cfg);
+
+public:
+  RegisterSet live_in(std::uint32_t block) const { return _live_in[block]; }
+
+  RegisterSet live_out(std::uint32_t block) const { return _live_out[block]; }
+};
+
+/**
+ * Gets the registers read by an instruction.
+ *
+ * @param instr The instruction
+ * @return RegisterSet
+ */
+RegisterSet uses(fnt::DenseInstr const &instr);
+
+/**
+ * Gets the registers written by an instruction.
+ *
+ * @param instr The instruction
+ * @return RegisterSet
+ */
+RegisterSet defines(fnt::DenseInstr const &instr);
+
+/**
+ * Checks if an instruction only writes a register which is not live after it.
+ * A division is never dead, since it may fail.
+ *
+ * @param instr The instruction
+ * @param live The registers live after the instruction
+ * @return true if the instruction can be removed, else, false
+ */
+bool is_dead(fnt::DenseInstr const &instr, RegisterSet live);
+
+/**
+ * Computes the registers live before an instruction.
+ *
+ * @param instr The instruction
+ * @param live The registers live after the instruction
+ * @return RegisterSet
+ */
+RegisterSet live_before(fnt::DenseInstr const &instr, RegisterSet live);
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * @file pass.hpp
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <front/ir.hpp>
+#include <optional>
+
+namespace cmp {
+
+namespace opt {
+
+/**
+ * Replaces the instructions of a program, and moves its labels to the new
+ * positions of their LABEL instructions. Label ids are kept, and a label whose
+ * instruction was removed becomes undefined.
+ *
+ * @param program The original program
+ * @param code The new instructions
+ * @return fnt::DenseProgram
+ */
+fnt::DenseProgram replace_code(fnt::DenseProgram const &program,
+                               fnt::DenseProgram::code_type code);
+
+/**
+ * Computes an arithmetic operation like the VM does, wrapping around on
+ * overflow.
+ *
+ * @param opcode The operation (add, sub, mul or div)
+ * @param lhs The left operand
+ * @param rhs The right operand
+ * @return std::optional<std::int32_t> The result, or nothing on a division by
+ * zero
+ */
+std::optional<std::int32_t> evaluate(fnt::Opcode opcode, std::int32_t lhs,
+                                     std::int32_t rhs);
+
+/**
+ * Checks if a conditional branch is taken.
+ *
+ * @param opcode The branch (be, bn, bg, bs, bge or bse)
+ * @param lhs The first compared register
+ * @param rhs The second compared register
+ * @return true if it is taken, else, false
+ */
+bool is_taken(fnt::Opcode opcode, std::int32_t lhs, std::int32_t rhs);
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,119 @@
+/**
+ * @file peephole.hpp
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <initializer_list>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace cmp {
+
+namespace opt {
+
+inline constexpr std::size_t MAX_WINDOW = 3;
+
+/**
+ * Set of opcodes, one bit per opcode, matched by a position of a rule.
+ */
+using OpcodeMask = std::uint32_t;
+
+constexpr OpcodeMask opcodes(std::initializer_list<fnt::Opcode> list) {
+  OpcodeMask res = 0;
+  for (auto opcode : list)
+    res |= OpcodeMask{1} << static_cast<int>(opcode);
+  return res;
+}
+
+inline constexpr OpcodeMask CONDITIONAL_BRANCHES =
+    opcodes({fnt::Opcode::BE, fnt::Opcode::BN, fnt::Opcode::BG,
+             fnt::Opcode::BS, fnt::Opcode::BGE, fnt::Opcode::BSE});
+inline constexpr OpcodeMask BRANCHES =
+    CONDITIONAL_BRANCHES | opcodes({fnt::Opcode::BR});
+
+/**
+ * Instructions replacing a window, at most as many as the window holds.
+ */
+struct Replacement {
+  std::array<fnt::DenseInstr, MAX_WINDOW> code;
+  std::size_t size = 0;
+
+  void push_back(fnt::DenseInstr const &instr) { code[size++] = instr; }
+};
+
+/**
+ * Rewrite rule of the peephole optimizer. A window of consecutive instructions
+ * matches if each opcode belongs to the mask at its position, and if the
+ * rewrite function accepts its operands. Labels are instructions too, so no
+ * branch can land inside a matched window, except on a label of the pattern.
+ *
+ * A rule must not grow the code, and must not be able to fire again on its
+ * own replacement forever, so that the optimizer stays linear.
+ */
+struct PeepholeRule {
+  std::string_view name;
+  std::array<OpcodeMask, MAX_WINDOW> pattern;
+  std::size_t length;
+  bool (*rewrite)(std::span<fnt::DenseInstr const> window, Replacement &res);
+};
+
+/**
+ * Number of times a rule fired.
+ */
+struct RuleCount {
+  std::string_view name;
+  std::size_t count = 0;
+};
+
+/**
+ * Counts of what the peephole optimizer changed in a program.
+ */
+struct PeepholeStats {
+  std::size_t instructions_before = 0;
+  std::size_t instructions_after = 0;
+  std::vector<RuleCount> fired;
+};
+
+/**
+ * Gets the default rules:
+ *   - ld rX 1, add rY rY rX (or rX rY) becomes ld rX 1, inc rY
+ *   - ld rX 1, sub rY rY rX becomes ld rX 1, dec rY
+ *   - inc r, dec r and dec r, inc r cancel out
+ *   - a branch to the label right after it is removed
+ *   - a conditional branch over a br is inverted to target the br label
+ *
+ * @return std::span<PeepholeRule const>
+ */
+std::span<PeepholeRule const> default_rules();
+
+/**
+ * Applies rewrite rules in a window sliding over the program until no rule
+ * matches anymore. Rules are tried in order, and after each rewrite the window
+ * steps back to see the instructions before the replacement.
+ *
+ * @param program The program
+ * @param rules The rules
+ * @param stats The counts of changes, filled by the pass
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram run_peephole(fnt::DenseProgram const &program,
+                               std::span<PeepholeRule const> rules,
+                               PeepholeStats &stats);
+
+/**
+ * Applies the default rules, without statistics.
+ *
+ * @param program The program
+ * @return fnt::DenseProgram The optimized program
+ */
+fnt::DenseProgram run_peephole(fnt::DenseProgram const &program);
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
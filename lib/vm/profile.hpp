@@ -0,0 +1,70 @@
+/**
+ * @file profile.hpp
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace vm {
+
+/**
+ * Number of times a sequence of adjacent operations ran.
+ */
+struct SequenceCount {
+  std::array<Op, MAX_FUSED_LENGTH> ops;
+  std::size_t length;
+  std::uint64_t count;
+};
+
+/**
+ * Frequencies of the adjacent operations of a program, over one or more runs.
+ * Only sequences that could be fused are counted: no branch but the last
+ * operation, and no branch target after the first one.
+ */
+struct Profile {
+  std::vector<SequenceCount> sequences;
+  std::array<std::uint64_t, static_cast<std::size_t>(Fused::_COUNT)> fused{};
+
+  /**
+   * Gets the pairs and triples that ran the most, most frequent first.
+   *
+   * @param count The maximum number of sequences
+   * @return std::vector<SequenceCount>
+   */
+  std::vector<SequenceCount> hottest(std::size_t count) const;
+};
+
+/**
+ * Runs a program with the switch loop while recording which pairs and triples
+ * of operations run, and adds them to a profile. Profiles of several programs
+ * can thus be accumulated into a training profile.
+ *
+ * @param executable The program
+ * @param state The state of the machine, updated in place
+ * @param profile The profile
+ */
+void run_profiled(Executable const &executable, State &state,
+                  Profile &profile);
+
+/**
+ * Selects the superinstructions covering the most executed instructions of a
+ * profile. The resulting mask can be given to Executable::lower, or baked in
+ * with CMP_SUPERINSTRUCTIONS.
+ *
+ * @param profile The profile
+ * @param limit The maximum number of superinstructions
+ * @return FusionSet
+ */
+FusionSet select_fusions(Profile const &profile,
+                         std::size_t limit = FUSED_PATTERNS.size());
+
+} // namespace vm
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,256 @@
+/**
+ * @file vm.hpp
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cmp {
+
+namespace vm {
+
+inline constexpr std::size_t REGISTER_COUNT = 10;
+inline constexpr std::size_t DEFAULT_MEMORY_SIZE = 1 << 16;
+
+/**
+ * Operation of a pre-decoded instruction. Labels are gone, and the program
+ * ends with HALT.
+ */
+enum class Op : std::uint8_t {
+  BR,
+  LD,
+  STR,
+  OUT,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  INC,
+  DEC,
+  BE,
+  BN,
+  BG,
+  BS,
+  BGE,
+  BSE,
+  HALT,
+  _COUNT,
+};
+
+/**
+ * Superinstruction of the threaded interpreter: a short sequence of
+ * operations run by a single fused handler, which saves the dispatches in
+ * between. Only the last operation of a sequence may be a branch.
+ */
+enum class Fused : std::uint8_t {
+  ADD_INC_BN,
+  INC_BN,
+  DEC_BN,
+  INC_BS,
+  SUB_BG,
+  LD_ADD,
+  ADD_INC,
+  MUL_ADD,
+  _COUNT,
+};
+
+inline constexpr std::size_t MAX_FUSED_LENGTH = 3;
+
+struct FusedPattern {
+  Fused id;
+  std::string_view name;
+  std::array<Op, MAX_FUSED_LENGTH> ops;
+  std::size_t length;
+};
+
+/**
+ * Catalog of the superinstructions with a fused handler, longest first, in
+ * the order they are tried when lowering.
+ */
+inline constexpr std::array<FusedPattern,
+                            static_cast<std::size_t>(Fused::_COUNT)>
+    FUSED_PATTERNS = {{
+        {Fused::ADD_INC_BN, "add+inc+bn", {Op::ADD, Op::INC, Op::BN}, 3},
+        {Fused::INC_BN, "inc+bn", {Op::INC, Op::BN}, 2},
+        {Fused::DEC_BN, "dec+bn", {Op::DEC, Op::BN}, 2},
+        {Fused::INC_BS, "inc+bs", {Op::INC, Op::BS}, 2},
+        {Fused::SUB_BG, "sub+bg", {Op::SUB, Op::BG}, 2},
+        {Fused::LD_ADD, "ld+add", {Op::LD, Op::ADD}, 2},
+        {Fused::ADD_INC, "add+inc", {Op::ADD, Op::INC}, 2},
+        {Fused::MUL_ADD, "mul+add", {Op::MUL, Op::ADD}, 2},
+    }};
+
+/**
+ * Set of enabled superinstructions, one bit per Fused value.
+ */
+using FusionSet = std::uint32_t;
+
+inline constexpr FusionSet NO_FUSIONS = 0;
+inline constexpr FusionSet ALL_FUSIONS =
+    (FusionSet{1} << static_cast<int>(Fused::_COUNT)) - 1;
+
+constexpr FusionSet fusion_bit(Fused id) {
+  return FusionSet{1} << static_cast<int>(id);
+}
+
+/**
+ * Gets the superinstructions enabled when none are given: the mask defined by
+ * CMP_SUPERINSTRUCTIONS at build time, as selected by the profiler over a
+ * training corpus, else none.
+ *
+ * @return FusionSet
+ */
+FusionSet default_fusions();
+
+/**
+ * Pre-decoded instruction. Operands follow the layout of fnt::DenseInstr, and
+ * branches hold the index of their target instead of a label. The handler is
+ * the address of the code executing the instruction in the threaded
+ * interpreter.
+ */
+struct Code {
+  void const *handler;
+  Op op;
+  std::uint8_t a;
+  std::uint8_t b;
+  std::uint8_t c;
+  std::int32_t imm;
+  std::uint32_t target;
+};
+
+/**
+ * State of a running program. Output is buffered until the program ends.
+ */
+struct State {
+  std::array<std::int32_t, REGISTER_COUNT> registers{};
+  std::vector<std::int32_t> memory;
+  std::string output;
+  std::uint64_t steps = 0;
+
+  explicit State(std::size_t memory_size = DEFAULT_MEMORY_SIZE);
+};
+
+/**
+ * Program lowered for execution: branch targets are resolved, operands are
+ * checked once and for all, and every instruction knows its handler.
+ */
+class Executable {
+private:
+  std::vector<Code> _code;
+  std::size_t _memory_size = DEFAULT_MEMORY_SIZE;
+
+public:
+  /**
+   * Lowers a program for execution. Throws if a branch refers to an undefined
+   * label or if a store is out of the memory.
+   *
+   * Sequences matching an enabled superinstruction are given its fused
+   * handler, scanning from the start of the program. A sequence never spans a
+   * branch target, and its instructions keep their own fields, so that only
+   * the threaded interpreter sees the difference.
+   *
+   * @param program The program
+   * @param memory_size The number of memory cells
+   * @param fusions The superinstructions to form
+   * @return Executable
+   */
+  static Executable lower(fnt::DenseProgram const &program,
+                          std::size_t memory_size = DEFAULT_MEMORY_SIZE,
+                          FusionSet fusions = default_fusions());
+
+public:
+  std::vector<Code> const &get_code() const;
+
+  std::size_t memory_size() const;
+};
+
+/**
+ * Runs a program with the direct-threaded interpreter: each handler jumps to
+ * the handler of the next instruction.
+ *
+ * @param executable The program
+ * @param state The state of the machine, updated in place
+ */
+void run_threaded(Executable const &executable, State &state);
+
+/**
+ * Runs a program with a plain switch loop. It is slower, and kept as a
+ * reference for the threaded interpreter.
+ *
+ * @param executable The program
+ * @param state The state of the machine, updated in place
+ */
+void run_switch(Executable const &executable, State &state);
+
+/**
+ * Runs a program from a fresh state and writes its output to a stream.
+ *
+ * @param program The program
+ * @param out The output stream
+ * @return State The final state of the machine
+ */
+State run(fnt::DenseProgram const &program, std::ostream &out);
+
+namespace detail {
+
+/**
+ * Gets the addresses of the handlers of the threaded interpreter, indexed by
+ * operation, then by superinstruction after the last operation.
+ *
+ * @return void const* const*
+ */
+void const *const *threaded_handlers();
+
+/**
+ * Marks the instructions which are the target of a branch.
+ *
+ * @param code The instructions
+ * @return std::vector<bool>
+ */
+std::vector<bool> branch_targets(std::vector<Code> const &code);
+
+/**
+ * Checks if a superinstruction can start at an instruction: the operations
+ * match, and no later instruction of the sequence is a branch target.
+ *
+ * @param code The instructions
+ * @param targets The branch targets of the instructions
+ * @param index The index of the first instruction
+ * @param pattern The superinstruction
+ * @return true if it matches, else, false
+ */
+bool matches(std::vector<Code> const &code, std::vector<bool> const &targets,
+             std::size_t index, FusedPattern const &pattern);
+
+/**
+ * Runs a program with the switch loop, counting how many times each
+ * instruction runs.
+ *
+ * @param executable The program
+ * @param state The state of the machine, updated in place
+ * @param hits The counts, one per instruction
+ */
+void run_counting(Executable const &executable, State &state,
+                  std::vector<std::uint64_t> &hits);
+
+/**
+ * Appends the decimal form of a value and a line break to an output buffer.
+ *
+ * @param buffer The output buffer
+ * @param value The value
+ */
+void output(std::string &buffer, std::int32_t value);
+
+} // namespace detail
+
+} // namespace vm
+
+} // namespace cmp
\ No newline at end of file
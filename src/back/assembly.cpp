@@ -0,0 +1,313 @@
+#include <array>
+#include <back/assembly.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace cmp {
+
+namespace bck {
+
+namespace {
+
+constexpr std::size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+
+/**
+ * Runtime linked into every program. cmp_out appends the decimal form of %edi
+ * and a line break to the output buffer, and only clobbers the scratch
+ * registers %eax, %ecx, %edx, %esi and %edi. cmp_flush also preserves %r11,
+ * which holds a guest register and is clobbered by syscall.
+ */
+char const *const RUNTIME = R"(
+        .text
+cmp_out:
+        movslq  %edi, %rax
+        movq    %rax, %rdi
+        testq   %rax, %rax
+        jns     1f
+        negq    %rax
+1:      leaq    cmp_digits+15(%rip), %rsi
+        movb    $10, (%rsi)
+        movl    $10, %ecx
+2:      xorl    %edx, %edx
+        divq    %rcx
+        addb    $48, %dl
+        decq    %rsi
+        movb    %dl, (%rsi)
+        testq   %rax, %rax
+        jnz     2b
+        testq   %rdi, %rdi
+        jns     3f
+        decq    %rsi
+        movb    $45, (%rsi)
+3:      leaq    cmp_digits+16(%rip), %rcx
+        subq    %rsi, %rcx
+        movq    cmp_used(%rip), %rax
+        addq    %rcx, %rax
+        cmpq    $CMP_BUFFER_SIZE, %rax
+        jbe     4f
+        call    cmp_flush
+4:      leaq    cmp_buffer(%rip), %rdi
+        addq    cmp_used(%rip), %rdi
+        addq    %rcx, cmp_used(%rip)
+        rep movsb
+        ret
+
+cmp_flush:
+        pushq   %rcx
+        pushq   %rsi
+        pushq   %r11
+        leaq    cmp_buffer(%rip), %rsi
+        movq    cmp_used(%rip), %rdx
+1:      testq   %rdx, %rdx
+        jz      2f
+        movl    $1, %eax
+        movl    $1, %edi
+        syscall
+        testq   %rax, %rax
+        jle     2f
+        addq    %rax, %rsi
+        subq    %rax, %rdx
+        jmp     1b
+2:      movq    $0, cmp_used(%rip)
+        popq    %r11
+        popq    %rsi
+        popq    %rcx
+        ret
+
+cmp_division_error:
+        call    cmp_flush
+        movl    $1, %eax
+        movl    $2, %edi
+        leaq    cmp_division_message(%rip), %rsi
+        movl    $18, %edx
+        syscall
+        movl    $231, %eax
+        movl    $1, %edi
+        syscall
+
+        .section .rodata
+cmp_division_message:
+        .ascii  "Division by zero.\n"
+
+        .bss
+        .align  8
+cmp_used:
+        .zero   8
+cmp_digits:
+        .zero   16
+cmp_buffer:
+        .zero   CMP_BUFFER_SIZE
+)";
+
+// Callee-saved registers first, so that only %r11 needs care around syscall.
+std::array<char const *, vm::REGISTER_COUNT> const HOST_REGISTERS = {
+    "%ebx",  "%ebp",  "%r12d", "%r13d", "%r14d",
+    "%r15d", "%r8d",  "%r9d",  "%r10d", "%r11d",
+};
+
+/**
+ * Appends one instruction to the assembly source.
+ *
+ * @param res The assembly source
+ * @param mnemonic The mnemonic
+ * @param operands The operands, in AT&T order
+ */
+void line(std::string &res, std::string const &mnemonic,
+          std::string const &operands = "") {
+  res += "        ";
+  res += mnemonic;
+  if (not operands.empty()) {
+    res.append(mnemonic.size() < 8 ? 8 - mnemonic.size() : 1, ' ');
+    res += operands;
+  }
+  res += '\n';
+}
+
+std::string reg(std::uint8_t id) { return detail::host_register(id); }
+
+std::string target_label(std::uint32_t target) {
+  return ".L" + std::to_string(target);
+}
+
+/**
+ * Emits a three-register operation a = b <op> c, without a move when the
+ * destination is also a source.
+ */
+void emit_binary(std::string &res, char const *mnemonic, vm::Code const &code,
+                 bool commutative) {
+  if (code.a == code.b) {
+    line(res, mnemonic, reg(code.c) + ", " + reg(code.a));
+  } else if (code.a == code.c and commutative) {
+    line(res, mnemonic, reg(code.b) + ", " + reg(code.a));
+  } else if (code.a != code.c) {
+    line(res, "movl", reg(code.b) + ", " + reg(code.a));
+    line(res, mnemonic, reg(code.c) + ", " + reg(code.a));
+  } else {
+    line(res, "movl", reg(code.b) + ", %eax");
+    line(res, mnemonic, reg(code.c) + ", %eax");
+    line(res, "movl", "%eax, " + reg(code.a));
+  }
+}
+
+/**
+ * Emits a division. Like the interpreters, a null divisor is an error and
+ * dividing by -1 negates, so that INT_MIN / -1 wraps instead of trapping.
+ */
+void emit_division(std::string &res, vm::Code const &code) {
+  line(res, "movl", reg(code.b) + ", %eax");
+  line(res, "movl", reg(code.c) + ", %ecx");
+  line(res, "testl", "%ecx, %ecx");
+  line(res, "jz", "cmp_division_error");
+  line(res, "cmpl", "$-1, %ecx");
+  line(res, "jne", "1f");
+  line(res, "negl", "%eax");
+  line(res, "jmp", "2f");
+  res += "1:\n";
+  line(res, "cltd");
+  line(res, "idivl", "%ecx");
+  res += "2:\n";
+  line(res, "movl", "%eax, " + reg(code.a));
+}
+
+void emit_branch(std::string &res, char const *mnemonic,
+                 vm::Code const &code) {
+  line(res, "cmpl", reg(code.b) + ", " + reg(code.a));
+  line(res, mnemonic, target_label(code.target));
+}
+
+void emit_code(std::string &res, vm::Code const &code) {
+  switch (code.op) {
+  case vm::Op::BR:
+    line(res, "jmp", target_label(code.target));
+    break;
+  case vm::Op::LD:
+    line(res, "movl", "$" + std::to_string(code.imm) + ", " + reg(code.a));
+    break;
+  case vm::Op::STR:
+    line(res, "movl",
+         reg(code.a) + ", cmp_memory+" + std::to_string(4 * code.imm) +
+             "(%rip)");
+    break;
+  case vm::Op::OUT:
+    line(res, "movl", reg(code.a) + ", %edi");
+    line(res, "call", "cmp_out");
+    break;
+  case vm::Op::ADD:
+    emit_binary(res, "addl", code, true);
+    break;
+  case vm::Op::SUB:
+    emit_binary(res, "subl", code, false);
+    break;
+  case vm::Op::MUL:
+    emit_binary(res, "imull", code, true);
+    break;
+  case vm::Op::DIV:
+    emit_division(res, code);
+    break;
+  case vm::Op::INC:
+    line(res, "incl", reg(code.a));
+    break;
+  case vm::Op::DEC:
+    line(res, "decl", reg(code.a));
+    break;
+  case vm::Op::BE:
+    emit_branch(res, "je", code);
+    break;
+  case vm::Op::BN:
+    emit_branch(res, "jne", code);
+    break;
+  case vm::Op::BG:
+    emit_branch(res, "jg", code);
+    break;
+  case vm::Op::BS:
+    emit_branch(res, "jl", code);
+    break;
+  case vm::Op::BGE:
+    emit_branch(res, "jge", code);
+    break;
+  case vm::Op::BSE:
+    emit_branch(res, "jle", code);
+    break;
+  case vm::Op::HALT:
+    line(res, "jmp", "cmp_exit");
+    break;
+  default:
+    throw std::runtime_error("Unknown operation.");
+  }
+}
+
+} // namespace
+
+std::string emit_assembly(vm::Executable const &executable) {
+  auto const &code = executable.get_code();
+  auto is_target = std::vector<bool>(code.size(), false);
+
+  for (auto const &c : code) {
+    if (c.op == vm::Op::BR or (c.op >= vm::Op::BE and c.op <= vm::Op::BSE))
+      is_target[c.target] = true;
+  }
+
+  auto res = std::string{};
+  line(res, ".set",
+       "CMP_BUFFER_SIZE, " + std::to_string(OUTPUT_BUFFER_SIZE));
+  line(res, ".text");
+  line(res, ".globl", "main");
+  line(res, ".type", "main, @function");
+  res += "main:\n";
+  for (auto const *saved : {"%rbx", "%rbp", "%r12", "%r13", "%r14", "%r15"})
+    line(res, "pushq", saved);
+  for (std::uint8_t id = 0; id < vm::REGISTER_COUNT; ++id)
+    line(res, "xorl", reg(id) + ", " + reg(id));
+
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    if (is_target[i])
+      res += target_label(static_cast<std::uint32_t>(i)) + ":\n";
+    emit_code(res, code[i]);
+  }
+
+  res += "cmp_exit:\n";
+  line(res, "call", "cmp_flush");
+  for (auto const *saved : {"%r15", "%r14", "%r13", "%r12", "%rbp", "%rbx"})
+    line(res, "popq", saved);
+  line(res, "xorl", "%eax, %eax");
+  line(res, "ret");
+  line(res, ".size", "main, .-main");
+
+  res += RUNTIME;
+  res += "cmp_memory:\n";
+  line(res, ".zero", std::to_string(4 * executable.memory_size()));
+  line(res, ".section", ".note.GNU-stack,\"\",@progbits");
+
+  return res;
+}
+
+std::string emit_assembly(fnt::DenseProgram const &program,
+                          std::size_t memory_size) {
+  return emit_assembly(vm::Executable::lower(program, memory_size));
+}
+
+void write_assembly(fnt::ProgramRepr const &repr, std::string const &path,
+                    std::size_t memory_size) {
+  auto text =
+      emit_assembly(fnt::DenseProgram::from_program_repr(repr), memory_size);
+  auto out = std::ofstream{path, std::ios::trunc};
+
+  if (not out.write(text.data(), static_cast<std::streamsize>(text.size())))
+    throw std::runtime_error("Assembly file could not be written.");
+}
+
+namespace detail {
+
+char const *host_register(std::uint8_t id) {
+  if (id >= vm::REGISTER_COUNT)
+    throw std::runtime_error("Register out of range: " + std::to_string(id));
+
+  return HOST_REGISTERS[id];
+}
+
+} // namespace detail
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
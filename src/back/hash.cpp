@@ -0,0 +1,60 @@
+#include <back/hash.hpp>
+#include <cstring>
+
+namespace cmp {
+
+namespace bck {
+
+namespace {
+
+constexpr std::uint64_t PRIME_1 = 0x9e3779b97f4a7c15;
+constexpr std::uint64_t PRIME_2 = 0xbf58476d1ce4e5b9;
+constexpr std::uint64_t PRIME_3 = 0x94d049bb133111eb;
+
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= PRIME_2;
+  x ^= x >> 27;
+  x *= PRIME_3;
+  x ^= x >> 31;
+
+  return x;
+}
+
+} // namespace
+
+std::uint64_t hash_bytes(void const *data, std::size_t size,
+                         std::uint64_t seed) {
+  auto bytes = static_cast<unsigned char const *>(data);
+  std::uint64_t lanes[4] = {seed ^ PRIME_1, seed ^ PRIME_2, seed ^ PRIME_3,
+                            seed + size};
+
+  // Four independent lanes keep several multiplications in flight.
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (int lane = 0; lane < 4; ++lane) {
+      std::uint64_t word;
+      std::memcpy(&word, bytes + i + 8 * lane, 8);
+      lanes[lane] = (lanes[lane] ^ word) * PRIME_1;
+      lanes[lane] ^= lanes[lane] >> 29;
+    }
+  }
+
+  std::uint64_t res = mix(lanes[0]) ^ mix(lanes[1] + PRIME_1) ^
+                      mix(lanes[2] + PRIME_2) ^ mix(lanes[3] + PRIME_3);
+
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + i, 8);
+    res = mix(res ^ word);
+  }
+
+  std::uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, size - i);
+
+  return mix(res ^ tail ^ (static_cast<std::uint64_t>(size - i) << 56));
+}
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include <back/jit.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace cmp {
+
+namespace bck {
+
+namespace {
+
+/**
+ * Precompiled machine code of an operation, with the positions of the bytes
+ * to patch. Guest registers live at [rbx + 4 * id], the memory starts at r12
+ * and r13 holds the machine state.
+ */
+struct Stencil {
+  std::vector<std::uint8_t> bytes;
+  int reg_a = -1;
+  int reg_b = -1;
+  int reg_c = -1;
+  int imm32 = -1;
+  int imm64 = -1;
+  int rel32 = -1;
+};
+
+// push rbx; push r12; push r13; mov rbx, rdi; mov r12, rsi; mov r13, rdx
+Stencil const PROLOGUE = {{0x53, 0x41, 0x54, 0x41, 0x55, 0x48, 0x89, 0xfb,
+                           0x49, 0x89, 0xf4, 0x49, 0x89, 0xd5}};
+
+// xor eax, eax; pop r13; pop r12; pop rbx; ret
+Stencil const HALT = {{0x31, 0xc0, 0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3}};
+
+// mov eax, 1; pop r13; pop r12; pop rbx; ret
+Stencil const DIVISION_ERROR = {
+    {0xb8, 0x01, 0x00, 0x00, 0x00, 0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3}};
+
+// jmp rel32
+Stencil const BR = {{0xe9, 0, 0, 0, 0}, -1, -1, -1, -1, -1, 1};
+
+// mov dword [rbx + a], imm32
+Stencil const LD = {{0xc7, 0x43, 0, 0, 0, 0, 0}, 2, -1, -1, 3};
+
+// mov eax, [rbx + a]; mov [r12 + imm32], eax
+Stencil const STR = {
+    {0x8b, 0x43, 0, 0x41, 0x89, 0x84, 0x24, 0, 0, 0, 0}, 2, -1, -1, 7};
+
+// mov rdi, r13; mov esi, [rbx + a]; mov rax, imm64; call rax
+Stencil const OUT = {{0x4c, 0x89, 0xef, 0x8b, 0x73, 0, 0x48, 0xb8, 0, 0, 0, 0,
+                      0, 0, 0, 0, 0xff, 0xd0},
+                     5, -1, -1, -1, 8};
+
+// mov eax, [rbx + b]; <op> eax, [rbx + c]; mov [rbx + a], eax
+Stencil const ADD = {{0x8b, 0x43, 0, 0x03, 0x43, 0, 0x89, 0x43, 0}, 8, 2, 5};
+Stencil const SUB = {{0x8b, 0x43, 0, 0x2b, 0x43, 0, 0x89, 0x43, 0}, 8, 2, 5};
+Stencil const MUL = {
+    {0x8b, 0x43, 0, 0x0f, 0xaf, 0x43, 0, 0x89, 0x43, 0}, 9, 2, 6};
+
+// mov eax, [rbx + b]; mov ecx, [rbx + c]; test ecx, ecx; jz error;
+// cmp ecx, -1; jne div; neg eax; jmp store; div: cdq; idiv ecx;
+// store: mov [rbx + a], eax
+Stencil const DIV = {{0x8b, 0x43, 0, 0x8b, 0x4b, 0, 0x85, 0xc9, 0x0f, 0x84,
+                      0, 0, 0, 0, 0x83, 0xf9, 0xff, 0x75, 0x04, 0xf7, 0xd8,
+                      0xeb, 0x03, 0x99, 0xf7, 0xf9, 0x89, 0x43, 0},
+                     28, 2, 5, -1, -1, 10};
+
+// inc dword [rbx + a] / dec dword [rbx + a]
+Stencil const INC = {{0xff, 0x43, 0}, 2};
+Stencil const DEC = {{0xff, 0x4b, 0}, 2};
+
+// mov eax, [rbx + a]; cmp eax, [rbx + b]; j<cc> rel32
+Stencil conditional(std::uint8_t condition) {
+  return {{0x8b, 0x43, 0, 0x3b, 0x43, 0, 0x0f, condition, 0, 0, 0, 0},
+          2, 5, -1, -1, -1, 8};
+}
+
+Stencil const BE = conditional(0x84);
+Stencil const BN = conditional(0x85);
+Stencil const BG = conditional(0x8f);
+Stencil const BS = conditional(0x8c);
+Stencil const BGE = conditional(0x8d);
+Stencil const BSE = conditional(0x8e);
+
+Stencil const &stencil_of(vm::Op op) {
+  switch (op) {
+  case vm::Op::BR:
+    return BR;
+  case vm::Op::LD:
+    return LD;
+  case vm::Op::STR:
+    return STR;
+  case vm::Op::OUT:
+    return OUT;
+  case vm::Op::ADD:
+    return ADD;
+  case vm::Op::SUB:
+    return SUB;
+  case vm::Op::MUL:
+    return MUL;
+  case vm::Op::DIV:
+    return DIV;
+  case vm::Op::INC:
+    return INC;
+  case vm::Op::DEC:
+    return DEC;
+  case vm::Op::BE:
+    return BE;
+  case vm::Op::BN:
+    return BN;
+  case vm::Op::BG:
+    return BG;
+  case vm::Op::BS:
+    return BS;
+  case vm::Op::BGE:
+    return BGE;
+  case vm::Op::BSE:
+    return BSE;
+  default:
+    return HALT;
+  }
+}
+
+void output(vm::State *state, std::int32_t value) noexcept {
+  vm::detail::output(state->output, value);
+}
+
+/**
+ * Branch displacement to patch once every instruction has its address.
+ */
+struct Fixup {
+  std::size_t position;
+  std::size_t target;
+  bool to_error;
+};
+
+void patch(std::vector<std::uint8_t> &code, int position, std::uint64_t value,
+           std::size_t size) {
+  std::memcpy(code.data() + position, &value, size);
+}
+
+std::vector<std::uint8_t> emit(vm::Executable const &executable) {
+  auto const &program = executable.get_code();
+  auto res = std::vector<std::uint8_t>{};
+  auto starts = std::vector<std::size_t>(program.size());
+  auto fixups = std::vector<Fixup>{};
+  auto helper = reinterpret_cast<std::uintptr_t>(&output);
+
+  res.reserve(program.size() * 12 + 64);
+  res.insert(res.end(), PROLOGUE.bytes.begin(), PROLOGUE.bytes.end());
+
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    auto const &code = program[i];
+    auto const &stencil = stencil_of(code.op);
+    auto base = static_cast<int>(res.size());
+
+    starts[i] = res.size();
+    res.insert(res.end(), stencil.bytes.begin(), stencil.bytes.end());
+
+    if (stencil.reg_a >= 0)
+      patch(res, base + stencil.reg_a, 4 * code.a, 1);
+    if (stencil.reg_b >= 0)
+      patch(res, base + stencil.reg_b, 4 * code.b, 1);
+    if (stencil.reg_c >= 0)
+      patch(res, base + stencil.reg_c, 4 * code.c, 1);
+    if (stencil.imm32 >= 0)
+      patch(res, base + stencil.imm32,
+            static_cast<std::uint32_t>(code.op == vm::Op::STR ? 4 * code.imm
+                                                               : code.imm),
+            4);
+    if (stencil.imm64 >= 0)
+      patch(res, base + stencil.imm64, helper, 8);
+    if (stencil.rel32 >= 0)
+      fixups.push_back({static_cast<std::size_t>(base + stencil.rel32),
+                        code.target, code.op == vm::Op::DIV});
+  }
+
+  auto error = res.size();
+  res.insert(res.end(), DIVISION_ERROR.bytes.begin(),
+             DIVISION_ERROR.bytes.end());
+
+  for (auto const &fixup : fixups) {
+    auto destination = fixup.to_error ? error : starts[fixup.target];
+    auto displacement = static_cast<std::int64_t>(destination) -
+                        static_cast<std::int64_t>(fixup.position + 4);
+    patch(res, static_cast<int>(fixup.position),
+          static_cast<std::uint32_t>(displacement), 4);
+  }
+
+  return res;
+}
+
+} // namespace
+
+bool jit_available() {
+#if defined(__x86_64__) and defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+JitProgram::JitProgram(JitProgram &&other) noexcept
+    : _code(std::exchange(other._code, nullptr)),
+      _code_size(std::exchange(other._code_size, 0)),
+      _memory_size(other._memory_size) {}
+
+JitProgram &JitProgram::operator=(JitProgram &&other) noexcept {
+  if (this != &other) {
+    release();
+    _code = std::exchange(other._code, nullptr);
+    _code_size = std::exchange(other._code_size, 0);
+    _memory_size = other._memory_size;
+  }
+
+  return *this;
+}
+
+JitProgram::~JitProgram() { release(); }
+
+void JitProgram::release() {
+  if (_code != nullptr)
+    ::munmap(_code, _code_size);
+
+  _code = nullptr;
+  _code_size = 0;
+}
+
+JitProgram JitProgram::compile(vm::Executable const &executable) {
+  if (not jit_available())
+    throw std::runtime_error("JIT is not available on this host.");
+
+  auto res = JitProgram{};
+  auto bytes = emit(executable);
+  auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  auto size = (bytes.size() + page - 1) / page * page;
+
+  void *code = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED)
+    throw std::runtime_error("JIT memory could not be allocated.");
+
+  res._code = code;
+  res._code_size = size;
+  res._memory_size = executable.memory_size();
+
+  std::memcpy(code, bytes.data(), bytes.size());
+  if (::mprotect(code, size, PROT_READ | PROT_EXEC) != 0)
+    throw std::runtime_error("JIT memory could not be made executable.");
+
+  return res;
+}
+
+JitProgram JitProgram::compile(fnt::DenseProgram const &program,
+                               std::size_t memory_size) {
+  return compile(vm::Executable::lower(program, memory_size));
+}
+
+void JitProgram::run(vm::State &state) const {
+  if (state.memory.size() < _memory_size)
+    state.memory.resize(_memory_size, 0);
+
+  auto entry = reinterpret_cast<entry_type>(_code);
+  if (entry(state.registers.data(), state.memory.data(), &state) != 0)
+    throw std::runtime_error("Division by zero.");
+}
+
+std::size_t JitProgram::code_size() const { return _code_size; }
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
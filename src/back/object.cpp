@@ -0,0 +1,269 @@
+#include <back/hash.hpp>
+#include <back/object.hpp>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace bck {
+
+static_assert(std::endian::native == std::endian::little,
+              "objects are encoded in little endian");
+static_assert(std::is_trivially_copyable_v<fnt::DenseInstr>,
+              "instructions are copied as is into objects");
+
+namespace {
+
+std::uint64_t align(std::uint64_t offset) { return (offset + 7) & ~7ull; }
+
+/**
+ * Checks that an instruction can be run as is: its opcode is known, its
+ * registers exist and its label, if any, is one of the object.
+ */
+bool is_well_formed(fnt::DenseInstr const &instr, std::uint64_t label_count) {
+  if (instr.opcode > fnt::Opcode::LABEL or instr.a >= vm::REGISTER_COUNT or
+      instr.b >= vm::REGISTER_COUNT or instr.c >= vm::REGISTER_COUNT)
+    return false;
+
+  if (fnt::is_branch(instr.opcode) or instr.opcode == fnt::Opcode::LABEL)
+    return instr.label() < label_count;
+
+  return true;
+}
+
+} // namespace
+
+std::string encode_object(fnt::DenseProgram const &program) {
+  auto const &symbols = program.get_symbols();
+
+  auto names = std::string{};
+  auto labels = std::vector<LabelEntry>(symbols.size());
+  for (std::uint32_t id = 0; id < symbols.size(); ++id) {
+    auto target = symbols.target(id);
+    labels[id] = {target == fnt::SymbolTable::NO_TARGET ? ~0ull : target,
+                  static_cast<std::uint32_t>(names.size()),
+                  static_cast<std::uint32_t>(symbols.name(id).size())};
+    names.append(symbols.name(id));
+  }
+
+  auto header = ObjectHeader{};
+  std::memcpy(header.magic, OBJECT_MAGIC, sizeof(header.magic));
+  header.version = OBJECT_VERSION;
+  header.instr_count = program.size();
+  header.label_count = labels.size();
+  header.code_offset = sizeof(ObjectHeader);
+  header.labels_offset =
+      align(header.code_offset + program.size() * sizeof(fnt::DenseInstr));
+  header.names_offset =
+      align(header.labels_offset + labels.size() * sizeof(LabelEntry));
+  header.names_size = names.size();
+
+  auto res = std::string(align(header.names_offset + names.size()), '\0');
+  std::memcpy(res.data() + header.code_offset, program.get_code().data(),
+              program.size() * sizeof(fnt::DenseInstr));
+  std::memcpy(res.data() + header.labels_offset, labels.data(),
+              labels.size() * sizeof(LabelEntry));
+  std::memcpy(res.data() + header.names_offset, names.data(), names.size());
+
+  header.checksum = hash_bytes(res.data() + sizeof(ObjectHeader),
+                               res.size() - sizeof(ObjectHeader));
+  std::memcpy(res.data(), &header, sizeof(header));
+
+  return res;
+}
+
+void write_object(fnt::DenseProgram const &program, std::string const &path) {
+  auto bytes = encode_object(program);
+  auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+
+  if (not out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+    throw std::runtime_error("Object file could not be written.");
+}
+
+void write_object(fnt::ProgramRepr const &repr, std::string const &path) {
+  write_object(fnt::DenseProgram::from_program_repr(repr), path);
+}
+
+namespace detail {
+
+ObjectHeader const &check_object(void const *data, std::size_t size,
+                                 bool verify) {
+  if (size < sizeof(ObjectHeader))
+    throw std::runtime_error("Object file is truncated.");
+
+  auto const &header = *static_cast<ObjectHeader const *>(data);
+
+  if (std::memcmp(header.magic, OBJECT_MAGIC, sizeof(header.magic)) != 0)
+    throw std::runtime_error("Not an object file.");
+
+  if (header.version != OBJECT_VERSION)
+    throw std::runtime_error("Unsupported object file version.");
+
+  // Sizes are checked one at a time so that none of the sums can overflow.
+  if (header.code_offset != sizeof(ObjectHeader) or
+      header.instr_count > size / sizeof(fnt::DenseInstr) or
+      header.label_count > size / sizeof(LabelEntry) or
+      header.names_size > size or header.labels_offset % 8 != 0 or
+      header.labels_offset < header.code_offset + header.instr_count *
+                                                      sizeof(fnt::DenseInstr) or
+      header.labels_offset > size or
+      header.names_offset < header.labels_offset + header.label_count *
+                                                       sizeof(LabelEntry) or
+      header.names_offset > size or
+      header.names_size > size - header.names_offset)
+    throw std::runtime_error("Object file is malformed.");
+
+  // Unverified objects are trusted, so that mapping them stays in constant
+  // time, without reading their content.
+  if (not verify)
+    return header;
+
+  auto body = static_cast<char const *>(data) + sizeof(ObjectHeader);
+  if (hash_bytes(body, size - sizeof(ObjectHeader)) != header.checksum)
+    throw std::runtime_error("Object file checksum mismatch.");
+
+  // The checksum only detects accidents, so the content is checked too:
+  // whoever can write the file can also fix its checksum.
+  auto base = static_cast<char const *>(data);
+  auto code = reinterpret_cast<fnt::DenseInstr const *>(base +
+                                                        header.code_offset);
+  for (std::uint64_t i = 0; i < header.instr_count; ++i) {
+    if (not is_well_formed(code[i], header.label_count))
+      throw std::runtime_error("Object file is malformed.");
+  }
+
+  auto labels =
+      reinterpret_cast<LabelEntry const *>(base + header.labels_offset);
+  for (std::uint64_t i = 0; i < header.label_count; ++i) {
+    auto const &entry = labels[i];
+    // A defined label targets the LABEL instruction defining it.
+    if ((entry.target != ~0ull and
+         (entry.target >= header.instr_count or
+          code[entry.target].opcode != fnt::Opcode::LABEL or
+          code[entry.target].label() != i)) or
+        std::uint64_t{entry.name_offset} + entry.name_length >
+            header.names_size)
+      throw std::runtime_error("Object file is malformed.");
+  }
+
+  return header;
+}
+
+} // namespace detail
+
+ObjectFile::ObjectFile(ObjectFile &&other) noexcept
+    : _mapped_data(std::exchange(other._mapped_data, nullptr)),
+      _mapped_size(std::exchange(other._mapped_size, 0)),
+      _header(std::exchange(other._header, nullptr)) {}
+
+ObjectFile &ObjectFile::operator=(ObjectFile &&other) noexcept {
+  if (this != &other) {
+    release();
+    _mapped_data = std::exchange(other._mapped_data, nullptr);
+    _mapped_size = std::exchange(other._mapped_size, 0);
+    _header = std::exchange(other._header, nullptr);
+  }
+
+  return *this;
+}
+
+ObjectFile::~ObjectFile() { release(); }
+
+void ObjectFile::release() {
+  if (_mapped_data != nullptr)
+    ::munmap(_mapped_data, _mapped_size);
+
+  _mapped_data = nullptr;
+  _mapped_size = 0;
+  _header = nullptr;
+}
+
+ObjectFile ObjectFile::map(std::string const &path, bool verify) {
+  auto res = ObjectFile{};
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Object file could not be open.");
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0 or info.st_size == 0) {
+    ::close(fd);
+    throw std::runtime_error("Object file is truncated.");
+  }
+
+  auto size = static_cast<std::size_t>(info.st_size);
+  void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (data == MAP_FAILED)
+    throw std::runtime_error("Object file could not be mapped.");
+
+  res._mapped_data = data;
+  res._mapped_size = size;
+  res._header = &detail::check_object(data, size, verify);
+
+  return res;
+}
+
+std::span<fnt::DenseInstr const> ObjectFile::get_code() const {
+  auto base = static_cast<char const *>(_mapped_data) + _header->code_offset;
+
+  return {reinterpret_cast<fnt::DenseInstr const *>(base),
+          static_cast<std::size_t>(_header->instr_count)};
+}
+
+std::size_t ObjectFile::label_count() const {
+  return static_cast<std::size_t>(_header->label_count);
+}
+
+LabelEntry const &ObjectFile::label_entry(std::uint32_t label) const {
+  auto base = static_cast<char const *>(_mapped_data) + _header->labels_offset;
+
+  return reinterpret_cast<LabelEntry const *>(base)[label];
+}
+
+std::string_view ObjectFile::label_name(std::uint32_t label) const {
+  auto const &entry = label_entry(label);
+  auto names = std::string_view{
+      static_cast<char const *>(_mapped_data) + _header->names_offset,
+      static_cast<std::size_t>(_header->names_size)};
+
+  return names.substr(entry.name_offset, entry.name_length);
+}
+
+std::size_t ObjectFile::label_target(std::uint32_t label) const {
+  auto target = label_entry(label).target;
+
+  return target == ~0ull ? fnt::SymbolTable::NO_TARGET
+                         : static_cast<std::size_t>(target);
+}
+
+fnt::DenseProgram ObjectFile::to_dense_program() const {
+  auto code = get_code();
+  auto symbols = fnt::SymbolTable{};
+
+  for (std::uint32_t id = 0; id < label_count(); ++id) {
+    // Ids are given in order of first appearance, so a name given twice
+    // would shift every following label.
+    if (symbols.intern(label_name(id)) != id)
+      throw std::runtime_error("Object file is malformed.");
+    if (auto target = label_target(id); target != fnt::SymbolTable::NO_TARGET)
+      symbols.define(id, target);
+  }
+
+  return fnt::DenseProgram::from_code({code.begin(), code.end()},
+                                      std::move(symbols));
+}
+
+} // namespace bck
+
+} // namespace cmp
\ No newline at end of file
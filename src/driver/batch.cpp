@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <back/object.hpp>
+#include <driver/batch.hpp>
+#include <driver/cache.hpp>
+#include <filesystem>
+#include <front/ir.hpp>
+#include <front/pool.hpp>
+#include <front/repr.hpp>
+#include <front/source.hpp>
+#include <front/token.hpp>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace cmp {
+
+namespace drv {
+
+namespace {
+
+/**
+ * Buffers kept by a worker from one file to the next.
+ */
+struct WorkerBuffers {
+  fnt::TokenTable::token_type tokens;
+};
+
+fnt::DenseProgram compile_source(fnt::TextSource const &source,
+                                 WorkerBuffers &buffers) {
+  auto tokens =
+      fnt::TokenTable::from_text_source(source, std::move(buffers.tokens));
+
+  // The buffers are given back even if the program is invalid.
+  auto res = fnt::DenseProgram{};
+  try {
+    res = fnt::DenseProgram::from_token_table(tokens);
+  } catch (...) {
+    buffers.tokens = tokens.release();
+    throw;
+  }
+  buffers.tokens = tokens.release();
+
+  return res;
+}
+
+void lint_one(CompileResult &res, WorkerBuffers &buffers) {
+  try {
+    auto source = fnt::TextSource::from_file(res.path);
+    auto tokens =
+        fnt::TokenTable::from_text_source(source, std::move(buffers.tokens));
+    auto program = fnt::ProgramRepr::try_from_token_table(tokens);
+    buffers.tokens = tokens.release();
+
+    if (program) {
+      res.instruction_count = program->get_instructions().size();
+      res.ok = true;
+      return;
+    }
+
+    for (auto const &diagnostic : program.error()) {
+      if (not res.diagnostic.empty())
+        res.diagnostic += '\n';
+      res.diagnostic += diagnostic.to_string(res.path);
+    }
+  } catch (std::exception const &e) {
+    // Only unreadable files get there.
+    res.diagnostic = res.path + ": " + e.what();
+  }
+}
+
+void compile_one(CompileResult &res, WorkerBuffers &buffers,
+                 CompileCache *cache) {
+  try {
+    auto source = fnt::TextSource::from_file(res.path);
+    auto program = fnt::DenseProgram{};
+
+    if (cache == nullptr) {
+      program = compile_source(source, buffers);
+    } else {
+      auto key = CacheKey::from_source(source.get_text());
+      if (auto cached = cache->load(key)) {
+        program = std::move(*cached);
+        res.cached = true;
+      } else {
+        // Invalid programs are not cached, they are reported again.
+        program = compile_source(source, buffers);
+        try {
+          cache->store(key, program);
+        } catch (std::exception const &) {
+          // The cache only saves time, the program is compiled anyway.
+        }
+      }
+    }
+
+    if (not res.object_path.empty())
+      bck::write_object(program, res.object_path);
+
+    res.instruction_count = program.size();
+    res.ok = true;
+  } catch (std::exception const &e) {
+    res.diagnostic = res.path + ": " + e.what();
+  }
+}
+
+} // namespace
+
+std::vector<SourceFile>
+collect_sources(std::vector<std::string> const &inputs) {
+  auto res = std::vector<SourceFile>{};
+
+  for (auto const &input : inputs) {
+    if (not std::filesystem::is_directory(input)) {
+      res.push_back(
+          {input, std::filesystem::path{input}.filename().string()});
+      continue;
+    }
+
+    auto found = std::vector<SourceFile>{};
+    for (auto const &entry :
+         std::filesystem::recursive_directory_iterator{input}) {
+      if (entry.is_regular_file() and entry.path().extension() == ".asm")
+        found.push_back(
+            {entry.path().string(),
+             entry.path().lexically_relative(input).string()});
+    }
+
+    // Directory iteration order depends on the file system.
+    std::sort(found.begin(), found.end(),
+              [](SourceFile const &lhs, SourceFile const &rhs) {
+                return lhs.path < rhs.path;
+              });
+    res.insert(res.end(), found.begin(), found.end());
+  }
+
+  return res;
+}
+
+std::vector<CompileResult> compile_batch(std::vector<SourceFile> const &sources,
+                                         BatchOptions const &options) {
+  auto res = std::vector<CompileResult>(sources.size());
+  auto outputs = std::unordered_set<std::string>{};
+
+  for (std::size_t i = 0; i < sources.size(); ++i) {
+    res[i].path = sources[i].path;
+    if (options.output_dir.empty() or options.lint)
+      continue;
+
+    res[i].object_path =
+        detail::object_path(sources[i].relative_path, options.output_dir);
+    if (not outputs.insert(res[i].object_path).second)
+      throw std::runtime_error("Several sources would be compiled into " +
+                               res[i].object_path);
+  }
+
+  // Created up front, so that workers only write files.
+  for (auto const &result : res)
+    if (not result.object_path.empty())
+      std::filesystem::create_directories(
+          std::filesystem::path{result.object_path}.parent_path());
+
+  auto pool = fnt::ThreadPool{options.thread_count};
+  auto buffers = std::vector<WorkerBuffers>(pool.size());
+
+  // Each result has its own slot, so workers never write to the same one.
+  for (auto &result : res)
+    pool.submit([&result, &buffers, &options](std::size_t worker) {
+      if (options.lint)
+        lint_one(result, buffers[worker]);
+      else
+        compile_one(result, buffers[worker], options.cache);
+    });
+  pool.wait();
+
+  if (options.cache != nullptr and not options.lint)
+    options.cache->evict();
+
+  return res;
+}
+
+namespace detail {
+
+std::string object_path(std::string const &relative_path,
+                        std::string const &output_dir) {
+  auto name = std::filesystem::path{relative_path};
+  name.replace_extension(".o");
+
+  return (std::filesystem::path{output_dir} / name).string();
+}
+
+} // namespace detail
+
+} // namespace drv
+
+} // namespace cmp
\ No newline at end of file
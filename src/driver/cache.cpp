@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <back/hash.hpp>
+#include <back/object.hpp>
+#include <chrono>
+#include <cstdio>
+#include <driver/cache.hpp>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace cmp {
+
+namespace drv {
+
+namespace {
+
+char const *const ENTRY_EXTENSION = ".o";
+char const *const TEMPORARY_PREFIX = "tmp-";
+
+// Temporary files older than this are left over by interrupted builds.
+constexpr auto STALE_TEMPORARY_AGE = std::chrono::hours{1};
+
+std::atomic<std::uint64_t> temporary_counter = 0;
+
+} // namespace
+
+CacheKey CacheKey::from_source(std::string_view source,
+                               std::uint64_t options) {
+  std::uint64_t const header[] = {COMPILER_VERSION, bck::OBJECT_VERSION,
+                                  options};
+  auto seed = bck::hash_bytes(header, sizeof(header));
+
+  // Two hashes with unrelated seeds make collisions negligible.
+  return {bck::hash_bytes(source.data(), source.size(), seed),
+          bck::hash_bytes(source.data(), source.size(), ~seed)};
+}
+
+std::string CacheKey::to_string() const {
+  char digits[33];
+  std::snprintf(digits, sizeof(digits), "%016llx%016llx",
+                static_cast<unsigned long long>(high),
+                static_cast<unsigned long long>(low));
+
+  return digits;
+}
+
+CompileCache::CompileCache(std::string const &dir, std::uintmax_t max_size)
+    : _dir(dir), _max_size(max_size) {
+  std::filesystem::create_directories(_dir);
+}
+
+std::optional<fnt::DenseProgram> CompileCache::load(CacheKey const &key) {
+  auto path = entry_path(key);
+
+  try {
+    auto object = bck::ObjectFile::map(path.string());
+    auto res = object.to_dense_program();
+
+    auto ec = std::error_code{};
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), ec);
+
+    ++_hits;
+    return res;
+  } catch (std::exception const &) {
+    // Missing, being evicted, or corrupted: compiling again replaces it.
+    ++_misses;
+    return std::nullopt;
+  }
+}
+
+void CompileCache::store(CacheKey const &key,
+                         fnt::DenseProgram const &program) {
+  auto path = entry_path(key);
+  auto temporary =
+      _dir / (TEMPORARY_PREFIX + std::to_string(::getpid()) + "-" +
+              std::to_string(
+                  std::hash<std::thread::id>{}(std::this_thread::get_id())) +
+              "-" + std::to_string(temporary_counter++));
+  auto bytes = bck::encode_object(program);
+
+  std::filesystem::create_directories(path.parent_path());
+  try {
+    {
+      auto out = std::ofstream{temporary, std::ios::binary | std::ios::trunc};
+      if (not out.write(bytes.data(),
+                        static_cast<std::streamsize>(bytes.size())) or
+          not out.flush())
+        throw std::runtime_error("Cache entry could not be written.");
+    }
+
+    // Renaming is atomic, so concurrent readers see the old entry or the new
+    // one, never a partial file.
+    std::filesystem::rename(temporary, path);
+  } catch (...) {
+    auto ec = std::error_code{};
+    std::filesystem::remove(temporary, ec);
+    throw;
+  }
+  ++_stores;
+}
+
+std::size_t CompileCache::evict() {
+  using entry_type =
+      std::tuple<std::filesystem::file_time_type, std::uintmax_t,
+                 std::filesystem::path>;
+
+  auto entries = std::vector<entry_type>{};
+  auto now = std::filesystem::file_time_type::clock::now();
+  std::uintmax_t total = 0;
+  auto ec = std::error_code{};
+
+  for (auto const &file : std::filesystem::recursive_directory_iterator{
+           _dir, std::filesystem::directory_options::skip_permission_denied,
+           ec}) {
+    if (not file.is_regular_file(ec))
+      continue;
+
+    auto name = file.path().filename().string();
+    auto time = file.last_write_time(ec);
+    if (ec)
+      continue;
+
+    if (name.rfind(TEMPORARY_PREFIX, 0) == 0) {
+      if (now - time > STALE_TEMPORARY_AGE)
+        std::filesystem::remove(file.path(), ec);
+      continue;
+    }
+    if (file.path().extension() != ENTRY_EXTENSION)
+      continue;
+
+    auto size = file.file_size(ec);
+    if (ec)
+      continue;
+
+    entries.emplace_back(time, size, file.path());
+    total += size;
+  }
+
+  if (total <= _max_size)
+    return 0;
+
+  std::sort(entries.begin(), entries.end());
+
+  std::size_t res = 0;
+  for (auto const &[time, size, path] : entries) {
+    if (total <= _max_size)
+      break;
+    // Another build may have evicted it already.
+    if (std::filesystem::remove(path, ec))
+      ++res;
+    total -= size;
+  }
+
+  _evictions += res;
+  return res;
+}
+
+CacheStats CompileCache::stats() const {
+  return {_hits, _misses, _stores, _evictions};
+}
+
+std::filesystem::path CompileCache::entry_path(CacheKey const &key) const {
+  // Entries are spread over 256 directories, to keep each one small.
+  auto name = key.to_string();
+
+  return _dir / name.substr(0, 2) / (name.substr(2) + ENTRY_EXTENSION);
+}
+
+} // namespace drv
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <front/diagnostic.hpp>
+
+namespace cmp {
+
+namespace fnt {
+
+std::string Diagnostic::to_string(std::string_view path) const {
+  auto res = std::string{path};
+
+  res += ':' + std::to_string(line) + ':' + std::to_string(column) + ": ";
+  res += message;
+
+  return res;
+}
+
+namespace detail {
+
+void locate_diagnostics(std::string_view text,
+                        std::vector<Diagnostic> &diagnostics) {
+  std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                   [](Diagnostic const &lhs, Diagnostic const &rhs) {
+                     return lhs.token < rhs.token;
+                   });
+
+  std::size_t position = 0;
+  std::size_t line = 1;
+  std::size_t line_start = 0;
+
+  for (auto &diagnostic : diagnostics) {
+    for (; position < diagnostic.offset; ++position)
+      if (text[position] == '\n') {
+        ++line;
+        line_start = position + 1;
+      }
+
+    diagnostic.line = line;
+    diagnostic.column = diagnostic.offset - line_start + 1;
+  }
+}
+
+} // namespace detail
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include <front/incremental.hpp>
+#include <front/mnemonic.hpp>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+namespace cmp {
+
+namespace fnt {
+
+namespace {
+
+std::vector<std::string> split_lines(std::string_view text) {
+  auto res = std::vector<std::string>{};
+
+  for (;;) {
+    auto end = text.find('\n');
+    res.emplace_back(text.substr(0, end));
+
+    if (end == std::string_view::npos)
+      break;
+
+    text.remove_prefix(end + 1);
+  }
+
+  return res;
+}
+
+template <typename F>
+void for_each_label(IncrementalProgram::Line const &line, F &&f) {
+  for (auto const &instr : line.instructions)
+    if (auto label = dynamic_cast<Label const *>(instr.get()))
+      f(label->label_id);
+}
+
+// Goes through every label name of a line, definitions and operands, even
+// those of a line which could not be parsed.
+template <typename F>
+void for_each_label_name(IncrementalProgram::Line const &line, F &&f) {
+  for (std::size_t i = 0; i < line.tokens.size(); ++i)
+    if (line.tokens.kind(i) == TokenKind::LABEL)
+      f(line.tokens.word(i));
+}
+
+constexpr std::string_view REDEFINITION = "Label defined twice.";
+
+} // namespace
+
+IncrementalProgram IncrementalProgram::from_text(std::string_view text) {
+  auto res = IncrementalProgram{};
+
+  for (auto &line_text : split_lines(text))
+    res._lines.push_back(
+        res.make_line(std::move(line_text), res._lines.size()));
+
+  auto pending = std::vector<Line *>{};
+  for (auto &line : res._lines)
+    if (not line->labels.empty())
+      pending.push_back(line.get());
+
+  res.settle_labels(std::move(pending));
+
+  return res;
+}
+
+std::unique_ptr<IncrementalProgram::Line>
+IncrementalProgram::make_line(std::string text, std::size_t number) {
+  auto res = std::make_unique<Line>();
+
+  res->number = number;
+  res->text = std::move(text);
+  parse_line(*res);
+
+  // Every label name is counted, even those of a line which could not be
+  // parsed, since the parser may have interned them before failing.
+  for_each_label_name(*res, [&](std::string_view name) {
+    auto id = _symbols.intern(name);
+    if (id >= _label_uses.size())
+      _label_uses.resize(id + 1, 0);
+    ++_label_uses[id];
+  });
+
+  for_each_label(*res, [&](std::uint32_t id) { res->labels.push_back(id); });
+
+  _label_lines.resize(_symbols.size(), nullptr);
+  _definers.resize(_symbols.size());
+  for (auto id : res->labels)
+    _definers[id].push_back(res.get());
+
+  return res;
+}
+
+void IncrementalProgram::parse_line(Line &line) {
+  line.tokens = TokenTable::token_type{line.text};
+  line.instructions.clear();
+  line.error.clear();
+  detail::extract_words(line.text, 0, line.text.size(), line.tokens);
+
+  auto const &tokens = line.tokens;
+  size_t i = 0;
+
+  try {
+    while (i < tokens.size()) {
+      if (i + operand_count(tokens.kind(i)) >= tokens.size())
+        throw std::runtime_error("Unexpected end of line.");
+
+      line.instructions.push_back(detail::make_instr(
+          tokens, i, _symbols, line.instructions.get_allocator().resource()));
+    }
+  } catch (std::exception const &error) {
+    line.instructions.clear();
+    line.error = error.what();
+  }
+}
+
+void IncrementalProgram::remove_line(Line const &line,
+                                     std::vector<std::uint32_t> &freed) {
+  for (auto id : line.labels) {
+    auto &definers = _definers[id];
+    definers.erase(std::find(definers.begin(), definers.end(), &line));
+
+    if (_label_lines[id] == &line) {
+      _label_lines[id] = nullptr;
+      freed.push_back(id);
+    }
+  }
+}
+
+void IncrementalProgram::release_labels(Line const &line) {
+  for_each_label_name(line, [&](std::string_view name) {
+    auto id = *_symbols.find(name);
+    if (--_label_uses[id] == 0)
+      _symbols.release(id);
+  });
+}
+
+bool IncrementalProgram::can_define_labels(Line const &line) const {
+  for (auto it = line.labels.begin(); it != line.labels.end(); ++it) {
+    auto owner = _label_lines[*it];
+    if (owner != nullptr and owner != &line and owner->number < line.number)
+      return false;
+
+    if (std::find(line.labels.begin(), it, *it) != it)
+      return false;
+  }
+
+  return true;
+}
+
+void IncrementalProgram::settle_labels(std::vector<Line *> pending) {
+  auto later = [](Line const *a, Line const *b) {
+    return a->number > b->number;
+  };
+
+  // Lines are checked in order, and a change only affects the following lines
+  // defining the same labels, so each line is settled once its previous lines
+  // are, as when the whole program is parsed.
+  std::make_heap(pending.begin(), pending.end(), later);
+  Line const *previous = nullptr;
+
+  while (not pending.empty()) {
+    std::pop_heap(pending.begin(), pending.end(), later);
+    auto &line = *pending.back();
+    pending.pop_back();
+
+    if (&line == previous)
+      continue;
+    previous = &line;
+
+    auto push = [&](Line *other) {
+      pending.push_back(other);
+      std::push_heap(pending.begin(), pending.end(), later);
+    };
+
+    if (can_define_labels(line)) {
+      for (auto id : line.labels) {
+        if (auto owner = _label_lines[id]; owner != nullptr and owner != &line)
+          push(owner);
+        _label_lines[id] = &line;
+      }
+
+      // A rejected line lost its instructions, and gets them back.
+      if (line.error == REDEFINITION)
+        parse_line(line);
+
+      continue;
+    }
+
+    for (auto id : line.labels) {
+      if (_label_lines[id] != &line)
+        continue;
+
+      _label_lines[id] = nullptr;
+      for (auto other : _definers[id])
+        if (other->number > line.number)
+          push(other);
+    }
+
+    line.instructions.clear();
+    line.error = REDEFINITION;
+  }
+}
+
+void IncrementalProgram::edit(TextEdit const &edit) {
+  if (edit.line >= _lines.size() or
+      edit.column > _lines[edit.line]->text.size())
+    throw std::out_of_range("Edit out of the program.");
+
+  // Finds the last line covered by the edited range, and what is left of it.
+  auto last = edit.line;
+  auto position = edit.column;
+  auto remaining = edit.length;
+
+  for (;;) {
+    auto available = _lines[last]->text.size() - position;
+    if (remaining <= available)
+      break;
+
+    if (last + 1 == _lines.size())
+      throw std::out_of_range("Edit out of the program.");
+
+    remaining -= available + 1;
+    position = 0;
+    ++last;
+  }
+
+  auto text = _lines[edit.line]->text.substr(0, edit.column);
+  text.append(edit.text);
+  text.append(
+      std::string_view{_lines[last]->text}.substr(position + remaining));
+
+  auto replacement = line_sequence_type{};
+  auto pending = std::vector<Line *>{};
+  for (auto &line_text : split_lines(text)) {
+    replacement.push_back(
+        make_line(std::move(line_text), edit.line + replacement.size()));
+    if (not replacement.back()->labels.empty())
+      pending.push_back(replacement.back().get());
+  }
+
+  // Names are released once the new lines hold theirs, so that a label kept
+  // by the edit keeps its id.
+  auto freed = std::vector<std::uint32_t>{};
+  for (auto i = edit.line; i <= last; ++i) {
+    remove_line(*_lines[i], freed);
+    release_labels(*_lines[i]);
+  }
+
+  for (auto id : freed)
+    pending.insert(pending.end(), _definers[id].begin(), _definers[id].end());
+
+  // Covered lines are replaced in place, and only the extra ones move the
+  // following lines.
+  auto removed = last + 1 - edit.line;
+  auto kept = std::min(removed, replacement.size());
+  auto at = [](auto &lines, std::size_t i) {
+    return lines.begin() + static_cast<std::ptrdiff_t>(i);
+  };
+
+  std::move(replacement.begin(), at(replacement, kept), at(_lines, edit.line));
+
+  if (replacement.size() > removed)
+    _lines.insert(at(_lines, edit.line + kept),
+                  std::make_move_iterator(at(replacement, kept)),
+                  std::make_move_iterator(replacement.end()));
+  else
+    _lines.erase(at(_lines, edit.line + kept), at(_lines, last + 1));
+
+  if (replacement.size() != removed)
+    for (auto i = edit.line + replacement.size(); i < _lines.size(); ++i)
+      _lines[i]->number = i;
+
+  settle_labels(std::move(pending));
+}
+
+IncrementalProgram::line_sequence_type const &
+IncrementalProgram::get_lines() const {
+  return _lines;
+}
+
+SymbolTable const &IncrementalProgram::get_symbols() const { return _symbols; }
+
+IncrementalProgram::Line const *
+IncrementalProgram::get_label_line(std::uint32_t id) const {
+  return id < _label_lines.size() ? _label_lines[id] : nullptr;
+}
+
+bool IncrementalProgram::has_errors() const {
+  for (auto const &line : _lines)
+    if (not line->error.empty())
+      return true;
+
+  return false;
+}
+
+std::string IncrementalProgram::get_text() const {
+  auto res = std::string{};
+
+  for (std::size_t i = 0; i < _lines.size(); ++i) {
+    if (i > 0)
+      res.push_back('\n');
+    res.append(_lines[i]->text);
+  }
+
+  return res;
+}
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -16,9 +16,15 @@ int get_register_id(std::string_view reg) {
   return std::stoi(std::string{reg[1]});
 }
 
+void check_operand_count(TokenTable::token_type const &table,
+                         std::size_t index, std::size_t count) {
+  if (index + count >= table.size())
+    throw std::runtime_error("Unexpected end of program.");
+}
+
 } // namespace detail
 
-BrInstr::BrInstr(std::string_view l) { label = l; }
+BrInstr::BrInstr(std::uint32_t l) { label_id = l; }
 
 LdInstr::LdInstr(std::string_view reg, std::string_view val) {
   reg_id = detail::get_register_id(reg);
@@ -70,337 +76,385 @@ DecInstr::DecInstr(std::string_view reg) {
   reg_id = detail::get_register_id(reg);
 }
 
-BeInstr::BeInstr(std::string_view l, std::string_view lhs,
+BeInstr::BeInstr(std::uint32_t l, std::string_view lhs,
                  std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-BnInstr::BnInstr(std::string_view l, std::string_view lhs,
+BnInstr::BnInstr(std::uint32_t l, std::string_view lhs,
                  std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-BgInstr::BgInstr(std::string_view l, std::string_view lhs,
+BgInstr::BgInstr(std::uint32_t l, std::string_view lhs,
                  std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-BsInstr::BsInstr(std::string_view l, std::string_view lhs,
+BsInstr::BsInstr(std::uint32_t l, std::string_view lhs,
                  std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-BgeInstr::BgeInstr(std::string_view l, std::string_view lhs,
+BgeInstr::BgeInstr(std::uint32_t l, std::string_view lhs,
                    std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-BseInstr::BseInstr(std::string_view l, std::string_view lhs,
+BseInstr::BseInstr(std::uint32_t l, std::string_view lhs,
                    std::string_view rhs) {
-  label = l;
+  label_id = l;
   lhs_id = detail::get_register_id(lhs);
   rhs_id = detail::get_register_id(rhs);
 }
 
-Label::Label(std::string_view l) { label = l; }
+Label::Label(std::uint32_t l) { label_id = l; }
+
+InstrPtr make_br_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 1);
 
-std::unique_ptr<Instr> make_br_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &dst_label = table[index + 1];
-  if (dst_label.second != TokenKind::LABEL)
+  auto dst_label = table[index + 1];
+  if (dst_label.kind != TokenKind::LABEL)
     throw std::runtime_error("br <label>");
 
   index += 2;
 
-  return std::make_unique<BrInstr>(dst_label.first);
+  return allocate_instr<BrInstr>(resource, symbols.intern(dst_label.word));
 }
 
-std::unique_ptr<Instr> make_ld_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &dst_reg = table[index + 1];
-  auto const &value = table[index + 2];
+InstrPtr make_ld_instr(TokenTable::token_type const &table, size_t &index,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 2);
 
-  if (dst_reg.second != TokenKind::REGISTER)
+  auto dst_reg = table[index + 1];
+  auto value = table[index + 2];
+
+  if (dst_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("ld <register> <value>");
 
-  if (value.second != TokenKind::INT_LIT)
+  if (value.kind != TokenKind::INT_LIT)
     throw std::runtime_error("ld <register> <value>");
 
   index += 3;
 
-  return std::make_unique<LdInstr>(dst_reg.first, value.first);
+  return allocate_instr<LdInstr>(resource, dst_reg.word, value.word);
 }
 
-std::unique_ptr<Instr> make_str_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &src_reg = table[index + 1];
-  auto const &mem_cell = table[index + 2];
+InstrPtr make_str_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 2);
+
+  auto src_reg = table[index + 1];
+  auto mem_cell = table[index + 2];
 
-  if (src_reg.second != TokenKind::REGISTER)
+  if (src_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("str <register> <memory>");
 
-  if (mem_cell.second != TokenKind::INT_LIT)
+  if (mem_cell.kind != TokenKind::INT_LIT)
     throw std::runtime_error("str <register> <memory>");
 
   index += 3;
 
-  return std::make_unique<StrInstr>(src_reg.first, mem_cell.first);
+  return allocate_instr<StrInstr>(resource, src_reg.word, mem_cell.word);
 }
 
-std::unique_ptr<Instr> make_out_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &reg = table[index + 1];
+InstrPtr make_out_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 1);
 
-  if (reg.second != TokenKind::REGISTER)
+  auto reg = table[index + 1];
+
+  if (reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("out <register>");
 
   index += 2;
 
-  return std::make_unique<OutInstr>(reg.first);
+  return allocate_instr<OutInstr>(resource, reg.word);
 }
 
-std::unique_ptr<Instr> make_add_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &dst_reg = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_add_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto dst_reg = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (dst_reg.second != TokenKind::REGISTER)
+  if (dst_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("add <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("add <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("add <destination> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<AddInstr>(dst_reg.first, lhs_reg.first,
-                                    rhs_reg.first);
+  return allocate_instr<AddInstr>(resource, dst_reg.word, lhs_reg.word,
+                                  rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_sub_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &dst_reg = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_sub_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto dst_reg = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (dst_reg.second != TokenKind::REGISTER)
+  if (dst_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("sub <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("sub <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("sub <destination> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<SubInstr>(dst_reg.first, lhs_reg.first,
-                                    rhs_reg.first);
+  return allocate_instr<SubInstr>(resource, dst_reg.word, lhs_reg.word,
+                                  rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_mul_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &dst_reg = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_mul_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
 
-  if (dst_reg.second != TokenKind::REGISTER)
+  auto dst_reg = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
+
+  if (dst_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("mul <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("mul <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("mul <destination> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<MulInstr>(dst_reg.first, lhs_reg.first,
-                                    rhs_reg.first);
+  return allocate_instr<MulInstr>(resource, dst_reg.word, lhs_reg.word,
+                                  rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_div_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &dst_reg = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_div_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto dst_reg = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (dst_reg.second != TokenKind::REGISTER)
+  if (dst_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("div <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("div <destination> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("div <destination> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<DivInstr>(dst_reg.first, lhs_reg.first,
-                                    rhs_reg.first);
+  return allocate_instr<DivInstr>(resource, dst_reg.word, lhs_reg.word,
+                                  rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_inc_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &reg = table[index + 1];
+InstrPtr make_inc_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 1);
 
-  if (reg.second != TokenKind::REGISTER)
-    throw std::runtime_error("inc <register");
+  auto reg = table[index + 1];
+
+  if (reg.kind != TokenKind::REGISTER)
+    throw std::runtime_error("inc <register>");
 
   index += 2;
 
-  return std::make_unique<IncInstr>(reg.first);
+  return allocate_instr<IncInstr>(resource, reg.word);
 }
 
-std::unique_ptr<Instr> make_dec_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &reg = table[index + 1];
+InstrPtr make_dec_instr(TokenTable::token_type const &table, size_t &index,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 1);
+
+  auto reg = table[index + 1];
 
-  if (reg.second != TokenKind::REGISTER)
-    throw std::runtime_error("dec <register");
+  if (reg.kind != TokenKind::REGISTER)
+    throw std::runtime_error("dec <register>");
 
   index += 2;
 
-  return std::make_unique<DecInstr>(reg.first);
+  return allocate_instr<DecInstr>(resource, reg.word);
 }
 
-std::unique_ptr<Instr> make_bn_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_bn_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (label.second != TokenKind::LABEL)
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("bn <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bn <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bn <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BnInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BnInstr>(resource, symbols.intern(label.word),
+                                 lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_be_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_be_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
 
-  if (label.second != TokenKind::LABEL)
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
+
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("be <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("be <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("be <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BeInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BeInstr>(resource, symbols.intern(label.word),
+                                 lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_bg_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_bg_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (label.second != TokenKind::LABEL)
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("bg <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bg <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bg <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BgInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BgInstr>(resource, symbols.intern(label.word),
+                                 lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_bs_instr(TokenTable::token_type const &table,
-                                     size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_bs_instr(TokenTable::token_type const &table, size_t &index,
+                       SymbolTable &symbols,
+                       std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
 
-  if (label.second != TokenKind::LABEL)
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
+
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("bs <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bs <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bs <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BsInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BsInstr>(resource, symbols.intern(label.word),
+                                 lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_bge_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_bge_instr(TokenTable::token_type const &table, size_t &index,
+                        SymbolTable &symbols,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (label.second != TokenKind::LABEL)
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("bge <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bge <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bge <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BgeInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BgeInstr>(resource, symbols.intern(label.word),
+                                  lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_bse_instr(TokenTable::token_type const &table,
-                                      size_t &index) {
-  auto const &label = table[index + 1];
-  auto const &lhs_reg = table[index + 2];
-  auto const &rhs_reg = table[index + 3];
+InstrPtr make_bse_instr(TokenTable::token_type const &table, size_t &index,
+                        SymbolTable &symbols,
+                        std::pmr::memory_resource *resource) {
+  detail::check_operand_count(table, index, 3);
+
+  auto label = table[index + 1];
+  auto lhs_reg = table[index + 2];
+  auto rhs_reg = table[index + 3];
 
-  if (label.second != TokenKind::LABEL)
+  if (label.kind != TokenKind::LABEL)
     throw std::runtime_error("bse <label> <lhs> <rhs>");
 
-  if (lhs_reg.second != TokenKind::REGISTER)
+  if (lhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bse <label> <lhs> <rhs>");
 
-  if (rhs_reg.second != TokenKind::REGISTER)
+  if (rhs_reg.kind != TokenKind::REGISTER)
     throw std::runtime_error("bse <label> <lhs> <rhs>");
 
   index += 4;
 
-  return std::make_unique<BseInstr>(label.first, lhs_reg.first, rhs_reg.first);
+  return allocate_instr<BseInstr>(resource, symbols.intern(label.word),
+                                  lhs_reg.word, rhs_reg.word);
 }
 
-std::unique_ptr<Instr> make_label(TokenTable::token_type const &table,
-                                  size_t &index) {
+InstrPtr make_label(TokenTable::token_type const &table, size_t &index,
+                    SymbolTable &symbols, std::pmr::memory_resource *resource) {
+  auto label = table[index];
+
   index++;
-  return std::make_unique<Label>(table[index].first);
+
+  return allocate_instr<Label>(resource, symbols.intern(label.word));
 }
 
 } // namespace fnt
@@ -0,0 +1,227 @@
+#include <front/ir.hpp>
+#include <front/metrics.hpp>
+#include <front/mnemonic.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace fnt {
+
+namespace {
+
+std::uint8_t reg(int id) { return static_cast<std::uint8_t>(id); }
+
+std::int32_t label(std::uint32_t id) { return static_cast<std::int32_t>(id); }
+
+template <typename T> DenseInstr lower_arith(Opcode opcode, T const &instr) {
+  return {opcode, reg(instr.dst_id), reg(instr.lhs_id), reg(instr.rhs_id), 0};
+}
+
+template <typename T> DenseInstr lower_cond(Opcode opcode, T const &instr) {
+  return {opcode, reg(instr.lhs_id), reg(instr.rhs_id), 0,
+          label(instr.label_id)};
+}
+
+Opcode opcode_of(TokenKind kind) {
+  switch (kind) {
+  case TokenKind::BR_INST:
+    return Opcode::BR;
+  case TokenKind::LD_INST:
+    return Opcode::LD;
+  case TokenKind::STR_INST:
+    return Opcode::STR;
+  case TokenKind::OUT_INST:
+    return Opcode::OUT;
+  case TokenKind::ADD_INST:
+    return Opcode::ADD;
+  case TokenKind::SUB_INST:
+    return Opcode::SUB;
+  case TokenKind::MUL_INST:
+    return Opcode::MUL;
+  case TokenKind::DIV_INST:
+    return Opcode::DIV;
+  case TokenKind::INC_INST:
+    return Opcode::INC;
+  case TokenKind::DEC_INST:
+    return Opcode::DEC;
+  case TokenKind::BE_INST:
+    return Opcode::BE;
+  case TokenKind::BN_INST:
+    return Opcode::BN;
+  case TokenKind::BG_INST:
+    return Opcode::BG;
+  case TokenKind::BS_INST:
+    return Opcode::BS;
+  case TokenKind::BGE_INST:
+    return Opcode::BGE;
+  case TokenKind::BSE_INST:
+    return Opcode::BSE;
+  default:
+    return Opcode::LABEL;
+  }
+}
+
+} // namespace
+
+DenseInstr BrInstr::lower() const {
+  return {Opcode::BR, 0, 0, 0, label(label_id)};
+}
+
+DenseInstr LdInstr::lower() const {
+  return {Opcode::LD, reg(reg_id), 0, 0, value};
+}
+
+DenseInstr StrInstr::lower() const {
+  return {Opcode::STR, reg(reg_id), 0, 0, memory_cell};
+}
+
+DenseInstr OutInstr::lower() const { return {Opcode::OUT, reg(reg_id)}; }
+
+DenseInstr AddInstr::lower() const { return lower_arith(Opcode::ADD, *this); }
+
+DenseInstr SubInstr::lower() const { return lower_arith(Opcode::SUB, *this); }
+
+DenseInstr MulInstr::lower() const { return lower_arith(Opcode::MUL, *this); }
+
+DenseInstr DivInstr::lower() const { return lower_arith(Opcode::DIV, *this); }
+
+DenseInstr IncInstr::lower() const { return {Opcode::INC, reg(reg_id)}; }
+
+DenseInstr DecInstr::lower() const { return {Opcode::DEC, reg(reg_id)}; }
+
+DenseInstr BeInstr::lower() const { return lower_cond(Opcode::BE, *this); }
+
+DenseInstr BnInstr::lower() const { return lower_cond(Opcode::BN, *this); }
+
+DenseInstr BgInstr::lower() const { return lower_cond(Opcode::BG, *this); }
+
+DenseInstr BsInstr::lower() const { return lower_cond(Opcode::BS, *this); }
+
+DenseInstr BgeInstr::lower() const { return lower_cond(Opcode::BGE, *this); }
+
+DenseInstr BseInstr::lower() const { return lower_cond(Opcode::BSE, *this); }
+
+DenseInstr Label::lower() const {
+  return {Opcode::LABEL, 0, 0, 0, label(label_id)};
+}
+
+bool is_branch(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::BR:
+  case Opcode::BE:
+  case Opcode::BN:
+  case Opcode::BG:
+  case Opcode::BS:
+  case Opcode::BGE:
+  case Opcode::BSE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+DenseProgram DenseProgram::from_program_repr(ProgramRepr const &repr) {
+  auto res = DenseProgram{};
+  auto const &instructions = repr.get_instructions();
+
+  res._code.reserve(instructions.size());
+  for (auto const &instr : instructions)
+    res._code.push_back(instr->lower());
+
+  res._symbols = repr.get_symbols();
+
+  return res;
+}
+
+DenseProgram DenseProgram::from_token_table(TokenTable const &table) {
+  auto timer = PhaseTimer{Phase::INSTRUCTION_BUILDING};
+  auto res = DenseProgram{};
+  auto const &tokens = table.get_table();
+
+  std::size_t i = 0;
+  while (i < tokens.size()) {
+    auto instr = detail::make_dense_instr(tokens, i, res._symbols);
+    if (instr.opcode == Opcode::LABEL)
+      res._symbols.define(instr.label(), res._code.size());
+
+    res._code.push_back(instr);
+  }
+
+  count(Counter::INSTRUCTIONS, res._code.size());
+
+  return res;
+}
+
+DenseProgram DenseProgram::from_code(code_type code, SymbolTable symbols) {
+  auto res = DenseProgram{};
+
+  res._code = std::move(code);
+  res._symbols = std::move(symbols);
+
+  return res;
+}
+
+DenseProgram::code_type const &DenseProgram::get_code() const { return _code; }
+
+SymbolTable const &DenseProgram::get_symbols() const { return _symbols; }
+
+std::size_t DenseProgram::label_count() const { return _symbols.size(); }
+
+std::string_view DenseProgram::label_name(std::uint32_t label) const {
+  return _symbols.name(label);
+}
+
+namespace detail {
+
+DenseInstr make_dense_instr(TokenTable::token_type const &table,
+                            std::size_t &index, SymbolTable &symbols) {
+  auto kind = table.kind(index);
+  if (kind == TokenKind::LABEL) {
+    auto id = symbols.intern(table.word(index));
+    ++index;
+    return {Opcode::LABEL, 0, 0, 0, label(id)};
+  }
+
+  auto mnemonic = mnemonic_of(kind);
+  if (mnemonic == nullptr)
+    throw std::runtime_error("Token inconnu.");
+
+  check_operand_count(table, index, mnemonic->operand_count);
+  for (std::size_t k = 0; k < mnemonic->operand_count; ++k)
+    if (table.kind(index + 1 + k) != mnemonic->operands[k])
+      throw std::runtime_error(std::string{mnemonic->usage});
+
+  // Registers fill a, b and c in order, and the integer or the label goes to
+  // imm, which gives the layout of every instruction.
+  auto res = DenseInstr{opcode_of(kind)};
+  std::uint8_t *registers[] = {&res.a, &res.b, &res.c};
+  std::size_t register_count = 0;
+
+  for (std::size_t k = 0; k < mnemonic->operand_count; ++k) {
+    auto word = table.word(index + 1 + k);
+
+    switch (mnemonic->operands[k]) {
+    case TokenKind::REGISTER:
+      *registers[register_count++] = reg(get_register_id(word));
+      break;
+    case TokenKind::INT_LIT:
+      res.imm = std::stoi(std::string{word});
+      break;
+    default:
+      res.imm = label(symbols.intern(word));
+      break;
+    }
+  }
+
+  index += mnemonic->operand_count + 1;
+
+  return res;
+}
+
+} // namespace detail
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
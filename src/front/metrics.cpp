@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <front/metrics.hpp>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace cmp {
+
+namespace fnt {
+
+namespace {
+
+// Events beyond this many per thread are dropped from the trace.
+constexpr std::size_t MAX_TRACE_EVENTS = std::size_t{1} << 16;
+
+char const *const PHASE_NAMES[PHASE_COUNT] = {
+    "file_read",
+    "word_extraction",
+    "classification",
+    "instruction_building",
+};
+
+// Allocation counter of the program, if it has one, and its value at the last
+// reset.
+std::atomic<std::atomic<std::uint64_t> const *> allocation_counter{nullptr};
+std::atomic<std::uint64_t> allocations_at_reset{0};
+
+struct TraceEvent {
+  Phase phase;
+  std::uint32_t thread_id;
+  std::uint64_t start;
+  std::uint64_t end;
+};
+
+struct Totals {
+  std::array<std::uint64_t, PHASE_COUNT> ticks{};
+  std::array<std::uint64_t, PHASE_COUNT> calls{};
+  std::array<std::uint64_t, COUNTER_COUNT> counts{};
+};
+
+/*
+ * Metrics of one thread. Only their thread writes them, so they are updated
+ * without atomic read-modify-write operations, but they are atomics so that
+ * they can be read while it runs.
+ */
+struct ThreadMetrics {
+  std::array<std::atomic<std::uint64_t>, PHASE_COUNT> ticks{};
+  std::array<std::atomic<std::uint64_t>, PHASE_COUNT> calls{};
+  std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counts{};
+  std::mutex events_mutex;
+  std::vector<TraceEvent> events;
+  std::uint32_t thread_id;
+
+  ThreadMetrics();
+  ~ThreadMetrics();
+};
+
+/*
+ * Every live thread that recorded metrics, and what the others left behind.
+ */
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadMetrics *> threads;
+  Totals retired;
+  std::vector<TraceEvent> retired_events;
+  std::uint32_t next_thread_id = 1;
+  // Reference point of the tick clock, to convert ticks to nanoseconds.
+  std::uint64_t start_ticks = detail::read_ticks();
+  std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+};
+
+Registry &registry() {
+  // Never destroyed, since threads may still be exiting at that point.
+  static auto *res = new Registry{};
+  return *res;
+}
+
+ThreadMetrics::ThreadMetrics() {
+  auto &reg = registry();
+  auto lock = std::lock_guard{reg.mutex};
+
+  thread_id = reg.next_thread_id++;
+  reg.threads.push_back(this);
+}
+
+ThreadMetrics::~ThreadMetrics() {
+  auto &reg = registry();
+  auto lock = std::lock_guard{reg.mutex};
+
+  for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+    reg.retired.ticks[i] += ticks[i].load(std::memory_order_relaxed);
+    reg.retired.calls[i] += calls[i].load(std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < COUNTER_COUNT; ++i)
+    reg.retired.counts[i] += counts[i].load(std::memory_order_relaxed);
+
+  reg.retired_events.insert(reg.retired_events.end(), events.begin(),
+                            events.end());
+  reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), this));
+}
+
+ThreadMetrics &thread_metrics() {
+  thread_local auto res = ThreadMetrics{};
+  return res;
+}
+
+/*
+ * Gets the ticks taken by reading the tick clock twice in a row, measured
+ * once. Sampled phases are not much longer than that.
+ */
+std::uint64_t read_overhead() {
+  static auto const res = [] {
+    auto best = ~std::uint64_t{0};
+    for (int i = 0; i < 64; ++i) {
+      auto start = detail::read_ticks();
+      best = std::min(best, detail::read_ticks() - start);
+    }
+    return best;
+  }();
+
+  return res;
+}
+
+void add(std::atomic<std::uint64_t> &metric, std::uint64_t value) {
+  metric.store(metric.load(std::memory_order_relaxed) + value,
+               std::memory_order_relaxed);
+}
+
+/*
+ * Gets the number of nanoseconds per tick, measured since the registry was
+ * created.
+ */
+double nanoseconds_per_tick(Registry const &reg) {
+#if defined(__x86_64__) || defined(__i386__)
+  auto ticks = detail::read_ticks() - reg.start_ticks;
+  auto nanoseconds = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - reg.start_time)
+                         .count();
+
+  return ticks == 0 ? 1.0 : nanoseconds / static_cast<double>(ticks);
+#else
+  (void)reg;
+  return 1.0;
+#endif
+}
+
+Totals sum_totals(Registry const &reg) {
+  auto res = reg.retired;
+
+  for (auto *thread : reg.threads) {
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+      res.ticks[i] += thread->ticks[i].load(std::memory_order_relaxed);
+      res.calls[i] += thread->calls[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i)
+      res.counts[i] += thread->counts[i].load(std::memory_order_relaxed);
+  }
+
+  return res;
+}
+
+} // namespace
+
+std::string Metrics::to_json() const {
+  auto res = std::string{"{\n  \"enabled\": "};
+  res += METRICS_ENABLED ? "true" : "false";
+  res += ",\n  \"phases\": {\n";
+
+  for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+    char line[128];
+    std::snprintf(line, sizeof(line),
+                  "    \"%s\": {\"nanoseconds\": %llu, \"calls\": %llu}%s\n",
+                  PHASE_NAMES[i],
+                  static_cast<unsigned long long>(phases[i].nanoseconds),
+                  static_cast<unsigned long long>(phases[i].calls),
+                  i + 1 < PHASE_COUNT ? "," : "");
+    res += line;
+  }
+
+  char counts[256];
+  std::snprintf(counts, sizeof(counts),
+                "  },\n  \"bytes\": %llu,\n  \"tokens\": %llu,\n"
+                "  \"instructions\": %llu,\n  \"allocations\": %llu\n}\n",
+                static_cast<unsigned long long>(bytes),
+                static_cast<unsigned long long>(tokens),
+                static_cast<unsigned long long>(instructions),
+                static_cast<unsigned long long>(allocations));
+  res += counts;
+
+  return res;
+}
+
+char const *phase_name(Phase phase) {
+  return PHASE_NAMES[static_cast<std::size_t>(phase)];
+}
+
+Metrics collect_metrics() {
+  auto res = Metrics{};
+  if constexpr (not METRICS_ENABLED)
+    return res;
+
+  auto &reg = registry();
+  auto lock = std::lock_guard{reg.mutex};
+  auto totals = sum_totals(reg);
+  auto scale = nanoseconds_per_tick(reg);
+
+  for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+    res.phases[i].nanoseconds = static_cast<std::uint64_t>(
+        static_cast<double>(totals.ticks[i]) * scale);
+    res.phases[i].calls = totals.calls[i];
+  }
+  res.bytes = totals.counts[static_cast<std::size_t>(Counter::BYTES)];
+  res.tokens = totals.counts[static_cast<std::size_t>(Counter::TOKENS)];
+  res.instructions =
+      totals.counts[static_cast<std::size_t>(Counter::INSTRUCTIONS)];
+  res.allocations = allocation_count() -
+                    allocations_at_reset.load(std::memory_order_relaxed);
+
+  return res;
+}
+
+void reset_metrics() {
+  if constexpr (not METRICS_ENABLED)
+    return;
+
+  auto &reg = registry();
+  auto lock = std::lock_guard{reg.mutex};
+
+  reg.retired = Totals{};
+  reg.retired_events.clear();
+  for (auto *thread : reg.threads) {
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+      thread->ticks[i].store(0, std::memory_order_relaxed);
+      thread->calls[i].store(0, std::memory_order_relaxed);
+    }
+    for (auto &count : thread->counts)
+      count.store(0, std::memory_order_relaxed);
+
+    auto events_lock = std::lock_guard{thread->events_mutex};
+    thread->events.clear();
+  }
+  allocations_at_reset.store(allocation_count(), std::memory_order_relaxed);
+}
+
+void set_allocation_counter(std::atomic<std::uint64_t> const *counter) {
+  allocation_counter.store(counter, std::memory_order_release);
+}
+
+std::uint64_t allocation_count() {
+  auto counter = allocation_counter.load(std::memory_order_acquire);
+
+  return counter != nullptr ? counter->load(std::memory_order_relaxed) : 0;
+}
+
+std::string chrome_trace() {
+  auto res = std::string{"{\"traceEvents\": ["};
+  if constexpr (not METRICS_ENABLED)
+    return res + "]}\n";
+
+  auto &reg = registry();
+  auto lock = std::lock_guard{reg.mutex};
+  auto events = reg.retired_events;
+  for (auto *thread : reg.threads) {
+    auto events_lock = std::lock_guard{thread->events_mutex};
+    events.insert(events.end(), thread->events.begin(), thread->events.end());
+  }
+
+  std::sort(events.begin(), events.end(),
+            [](TraceEvent const &lhs, TraceEvent const &rhs) {
+              return lhs.start < rhs.start;
+            });
+
+  // Timestamps are in microseconds since the first recorded event, which may
+  // have started before the registry was created.
+  auto scale = nanoseconds_per_tick(reg) / 1000.0;
+  auto origin = events.empty() ? reg.start_ticks
+                               : std::min(reg.start_ticks, events[0].start);
+  auto pid = static_cast<long>(::getpid());
+  bool first = true;
+
+  for (auto const &event : events) {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%s\n  {\"name\": \"%s\", \"cat\": \"front\", \"ph\": \"X\", "
+                  "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %ld, \"tid\": %u}",
+                  first ? "" : ",", phase_name(event.phase),
+                  static_cast<double>(event.start - origin) * scale,
+                  static_cast<double>(event.end - event.start) * scale, pid,
+                  static_cast<unsigned>(event.thread_id));
+    res += line;
+    first = false;
+  }
+
+  return res + "\n], \"displayTimeUnit\": \"ns\"}\n";
+}
+
+namespace detail {
+
+void record_phase(Phase phase, std::uint64_t start, std::uint64_t end) {
+  auto &metrics = thread_metrics();
+  auto index = static_cast<std::size_t>(phase);
+
+  add(metrics.ticks[index], end - start);
+  add(metrics.calls[index], 1);
+
+  auto lock = std::lock_guard{metrics.events_mutex};
+  if (metrics.events.size() < MAX_TRACE_EVENTS)
+    metrics.events.push_back({phase, metrics.thread_id, start, end});
+}
+
+void record_sampled_phase(Phase phase, std::uint64_t ticks,
+                          std::uint64_t samples, std::uint64_t runs) {
+  auto &metrics = thread_metrics();
+  auto index = static_cast<std::size_t>(phase);
+  auto overhead = read_overhead() * samples;
+
+  ticks = ticks > overhead ? ticks - overhead : 0;
+  add(metrics.ticks[index],
+      static_cast<std::uint64_t>(static_cast<double>(ticks) *
+                                 static_cast<double>(runs) /
+                                 static_cast<double>(samples)));
+  add(metrics.calls[index], runs);
+}
+
+void record_count(Counter counter, std::uint64_t value) {
+  add(thread_metrics().counts[static_cast<std::size_t>(counter)], value);
+}
+
+} // namespace detail
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
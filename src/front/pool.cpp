@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <front/pool.hpp>
+#include <utility>
+
+namespace cmp {
+
+namespace fnt {
+
+ThreadPool::ThreadPool(std::size_t thread_count) {
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+  for (std::size_t i = 0; i < thread_count; ++i)
+    _queues.push_back(std::make_unique<Queue>());
+  for (std::size_t i = 0; i < thread_count; ++i)
+    _workers.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    auto lock = std::lock_guard{_mutex};
+    _stopping = true;
+  }
+  _wake.notify_all();
+
+  for (auto &worker : _workers)
+    worker.join();
+}
+
+void ThreadPool::submit(task_type task) {
+  // Counted first, under the pool lock, so that the task can neither finish
+  // before it is counted nor be missed by a worker about to sleep.
+  {
+    auto lock = std::lock_guard{_mutex};
+    ++_pending;
+    ++_queued;
+  }
+
+  auto &queue = *_queues[_next++ % _queues.size()];
+  {
+    auto lock = std::lock_guard{queue.mutex};
+    queue.tasks.push_back(std::move(task));
+  }
+  _wake.notify_one();
+}
+
+void ThreadPool::wait() {
+  auto lock = std::unique_lock{_mutex};
+  _idle.wait(lock, [this] { return _pending == 0; });
+}
+
+bool ThreadPool::take(std::size_t index, task_type &task) {
+  {
+    auto &own = *_queues[index];
+    auto lock = std::lock_guard{own.mutex};
+    if (not own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (std::size_t i = 1; i < _queues.size(); ++i) {
+    auto &other = *_queues[(index + i) % _queues.size()];
+    auto lock = std::lock_guard{other.mutex};
+    if (not other.tasks.empty()) {
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::work(std::size_t index) {
+  auto task = task_type{};
+
+  for (;;) {
+    if (take(index, task)) {
+      --_queued;
+      task(index);
+      task = nullptr;
+
+      if (--_pending == 0) {
+        auto lock = std::lock_guard{_mutex};
+        _idle.notify_all();
+      }
+      continue;
+    }
+
+    auto lock = std::unique_lock{_mutex};
+    _wake.wait(lock, [this] { return _stopping or _queued > 0; });
+    if (_stopping and _queued == 0)
+      return;
+  }
+}
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
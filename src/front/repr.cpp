@@ -1,15 +1,226 @@
+#include <charconv>
+#include <front/metrics.hpp>
+#include <front/mnemonic.hpp>
 #include <front/repr.hpp>
+#include <front/stream.hpp>
 #include <front/token.hpp>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 namespace cmp {
 
 namespace fnt {
 
-ProgramRepr ProgramRepr::from_token_table(const TokenTable &table) {
-  auto res = ProgramRepr{};
+namespace {
 
-  res._instr_sequence = detail::gather_tokens(table);
+char const *describe(TokenKind kind) {
+  switch (kind) {
+  case TokenKind::INT_LIT:
+    return "an integer";
+  case TokenKind::LABEL:
+    return "a label";
+  case TokenKind::REGISTER:
+    return "a register";
+  default:
+    return mnemonic_of(kind) != nullptr ? "an instruction" : "an unknown word";
+  }
+}
+
+bool fits_int(std::string_view word) {
+  int value;
+  auto [end, error] =
+      std::from_chars(word.data(), word.data() + word.size(), value);
+
+  return error == std::errc{} and end == word.data() + word.size();
+}
+
+bool starts_line(TokenTable::token_type const &table, std::size_t index) {
+  if (index == 0)
+    return true;
+
+  auto end = table.offset(index - 1) + table.word(index - 1).size();
+  auto gap = table.source().substr(end, table.offset(index) - end);
+
+  return gap.find('\n') != std::string_view::npos;
+}
+
+/*
+ * Finds where parsing resumes after an error: the next instruction word, or
+ * the next label starting a line, which must be a label definition.
+ */
+std::size_t resume_index(TokenTable::token_type const &table,
+                         std::size_t index) {
+  while (index < table.size() and
+         mnemonic_of(table.kind(index)) == nullptr and
+         not(table.kind(index) == TokenKind::LABEL and
+             starts_line(table, index)))
+    ++index;
+
+  return index;
+}
+
+} // namespace
+
+ProgramRepr::ProgramRepr(std::pmr::memory_resource *resource)
+    : _instr_sequence(resource), _symbols(resource) {}
+
+ProgramRepr ProgramRepr::from_token_table(const TokenTable &table,
+                                          std::pmr::memory_resource *resource) {
+  auto res = ProgramRepr{resource};
+
+  res._instr_sequence = detail::gather_tokens(table, res._symbols, resource);
+
+  return res;
+}
+
+Expected<ProgramRepr, std::vector<Diagnostic>>
+ProgramRepr::try_from_token_table(TokenTable const &table,
+                                  std::pmr::memory_resource *resource) {
+  auto timer = PhaseTimer{Phase::INSTRUCTION_BUILDING};
+  auto res = ProgramRepr{resource};
+  auto const &tokens = table.get_table();
+  auto diagnostics = std::vector<Diagnostic>{};
+  // Label operands of the branches, checked once every label is defined.
+  auto references = std::vector<std::size_t>{};
+
+  auto report = [&](std::size_t token, std::string message) {
+    diagnostics.push_back({token, tokens.offset(token), 0, 0,
+                           std::move(message)});
+  };
+
+  std::size_t i = 0;
+  while (i < tokens.size()) {
+    auto kind = tokens.kind(i);
+
+    if (kind == TokenKind::LABEL) {
+      auto id = res._symbols.intern(tokens.word(i));
+      if (res._symbols.target(id) == SymbolTable::NO_TARGET) {
+        detail::push_instr(res._instr_sequence,
+                           make_label(tokens, i, res._symbols, resource),
+                           res._symbols);
+      } else {
+        report(i, "Label defined twice: " + std::string{tokens.word(i)});
+        ++i;
+      }
+      continue;
+    }
+
+    auto mnemonic = mnemonic_of(kind);
+    if (mnemonic == nullptr) {
+      report(i, std::string{"Expected an instruction or a label, found "} +
+                    describe(kind) + ": " + std::string{tokens.word(i)});
+      i = resume_index(tokens, i + 1);
+      continue;
+    }
+
+    if (i + mnemonic->operand_count >= tokens.size()) {
+      report(i, "Unexpected end of program: " + std::string{mnemonic->usage});
+      break;
+    }
+
+    bool valid = true;
+    for (std::size_t k = 0; k < mnemonic->operand_count; ++k) {
+      auto operand = i + 1 + k;
+      auto expected = mnemonic->operands[k];
+
+      if (tokens.kind(operand) != expected) {
+        report(operand, std::string{mnemonic->usage} + ": expected " +
+                            describe(expected) + ", found " +
+                            describe(tokens.kind(operand)) + ": " +
+                            std::string{tokens.word(operand)});
+        valid = false;
+        break;
+      }
+
+      if (expected == TokenKind::INT_LIT and
+          not fits_int(tokens.word(operand))) {
+        report(operand,
+               "Integer out of range: " + std::string{tokens.word(operand)});
+        valid = false;
+        break;
+      }
+    }
+
+    if (not valid) {
+      i = resume_index(tokens, i + 1);
+      continue;
+    }
+
+    for (std::size_t k = 0; k < mnemonic->operand_count; ++k)
+      if (mnemonic->operands[k] == TokenKind::LABEL)
+        references.push_back(i + 1 + k);
+
+    // Operands are checked, so the instruction is made without error.
+    res._instr_sequence.push_back(
+        detail::make_instr(tokens, i, res._symbols, resource));
+  }
+
+  for (auto reference : references) {
+    auto id = res._symbols.find(tokens.word(reference));
+    if (res._symbols.target(*id) == SymbolTable::NO_TARGET)
+      report(reference,
+             "Undefined label: " + std::string{tokens.word(reference)});
+  }
+
+  if (not diagnostics.empty()) {
+    detail::locate_diagnostics(tokens.source(), diagnostics);
+    return Unexpected<std::vector<Diagnostic>>{std::move(diagnostics)};
+  }
+
+  count(Counter::INSTRUCTIONS, res._instr_sequence.size());
+
+  return res;
+}
+
+ProgramRepr ProgramRepr::from_stream(std::istream &input,
+                                     std::size_t chunk_size,
+                                     std::pmr::memory_resource *resource) {
+  auto res = ProgramRepr{resource};
+  auto lexer = StreamLexer{input, chunk_size};
+
+  // Tokens of the instruction being read. Their words are copied into a small
+  // buffer, since the lexer only keeps the last one alive.
+  auto words = std::string{};
+  auto offsets = std::vector<std::size_t>{};
+  auto kinds = std::vector<TokenKind>{};
+  auto window = TokenTable::token_type{};
+
+  while (auto token = lexer.next()) {
+    words.clear();
+    offsets.clear();
+    kinds.clear();
+
+    auto count = operand_count(token->kind) + 1;
+    for (;;) {
+      offsets.push_back(words.size());
+      kinds.push_back(token->kind);
+      words.append(token->word);
+
+      if (kinds.size() == count)
+        break;
+
+      token = lexer.next();
+      if (not token)
+        throw std::runtime_error("Unexpected end of program.");
+    }
+
+    window.reset(words);
+    for (size_t i = 0; i < kinds.size(); ++i) {
+      auto end = i + 1 < kinds.size() ? offsets[i + 1] : words.size();
+      window.push_back(kinds[i], offsets[i], end - offsets[i]);
+    }
+
+    size_t index = 0;
+    detail::push_instr(res._instr_sequence,
+                       detail::make_instr(window, index, res._symbols,
+                                          resource),
+                       res._symbols);
+  }
+
+  count(Counter::INSTRUCTIONS, res._instr_sequence.size());
 
   return res;
 }
@@ -18,74 +229,76 @@ ProgramRepr::instr_sequence_type const &ProgramRepr::get_instructions() const {
   return _instr_sequence;
 }
 
+SymbolTable const &ProgramRepr::get_symbols() const { return _symbols; }
+
 namespace detail {
 
-ProgramRepr::instr_sequence_type gather_tokens(const TokenTable &table) {
-  auto res = ProgramRepr::instr_sequence_type{};
+ProgramRepr::instr_sequence_type
+gather_tokens(const TokenTable &table, SymbolTable &symbols,
+              std::pmr::memory_resource *resource) {
+  auto timer = PhaseTimer{Phase::INSTRUCTION_BUILDING};
+  auto res = ProgramRepr::instr_sequence_type{resource};
   auto const &raw_table = table.get_table();
 
   size_t i = 0;
-  while (i < raw_table.size()) {
-    switch (raw_table[i].second) {
-    case TokenKind::BR_INST:
-      res.emplace_back(make_br_instr(raw_table, i));
-      break;
-    case TokenKind::LD_INST:
-      res.emplace_back(make_ld_instr(raw_table, i));
-      break;
-    case TokenKind::STR_INST:
-      res.emplace_back(make_str_instr(raw_table, i));
-      break;
-    case TokenKind::OUT_INST:
-      res.emplace_back(make_out_instr(raw_table, i));
-      break;
-    case TokenKind::ADD_INST:
-      res.emplace_back(make_add_instr(raw_table, i));
-      break;
-    case TokenKind::SUB_INST:
-      res.emplace_back(make_sub_instr(raw_table, i));
-      break;
-    case TokenKind::MUL_INST:
-      res.emplace_back(make_mul_instr(raw_table, i));
-      break;
-    case TokenKind::DIV_INST:
-      res.emplace_back(make_div_instr(raw_table, i));
-      break;
-    case TokenKind::INC_INST:
-      res.emplace_back(make_inc_instr(raw_table, i));
-      break;
-    case TokenKind::DEC_INST:
-      res.emplace_back(make_dec_instr(raw_table, i));
-      break;
-    case TokenKind::BE_INST:
-      res.emplace_back(make_be_instr(raw_table, i));
-      break;
-    case TokenKind::BN_INST:
-      res.emplace_back(make_bn_instr(raw_table, i));
-      break;
-    case TokenKind::BG_INST:
-      res.emplace_back(make_bg_instr(raw_table, i));
-      break;
-    case TokenKind::BS_INST:
-      res.emplace_back(make_bs_instr(raw_table, i));
-      break;
-    case TokenKind::BGE_INST:
-      res.emplace_back(make_bge_instr(raw_table, i));
-      break;
-    case TokenKind::BSE_INST:
-      res.emplace_back(make_bse_instr(raw_table, i));
-      break;
-    case TokenKind::LABEL:
-      res.emplace_back(make_label(raw_table, i));
-      break;
-    default:
-      throw std::runtime_error("Token inconnu.");
-    }
-  }
+  while (i < raw_table.size())
+    push_instr(res, make_instr(raw_table, i, symbols, resource), symbols);
+
+  count(Counter::INSTRUCTIONS, res.size());
 
   return res;
 }
 
+void push_instr(ProgramRepr::instr_sequence_type &sequence, InstrPtr instr,
+                SymbolTable &symbols) {
+  if (auto label = dynamic_cast<Label const *>(instr.get()))
+    symbols.define(label->label_id, sequence.size());
+
+  sequence.push_back(std::move(instr));
+}
+
+InstrPtr make_instr(TokenTable::token_type const &table, size_t &index,
+                    SymbolTable &symbols, std::pmr::memory_resource *resource) {
+  switch (table.kind(index)) {
+  case TokenKind::BR_INST:
+    return make_br_instr(table, index, symbols, resource);
+  case TokenKind::LD_INST:
+    return make_ld_instr(table, index, resource);
+  case TokenKind::STR_INST:
+    return make_str_instr(table, index, resource);
+  case TokenKind::OUT_INST:
+    return make_out_instr(table, index, resource);
+  case TokenKind::ADD_INST:
+    return make_add_instr(table, index, resource);
+  case TokenKind::SUB_INST:
+    return make_sub_instr(table, index, resource);
+  case TokenKind::MUL_INST:
+    return make_mul_instr(table, index, resource);
+  case TokenKind::DIV_INST:
+    return make_div_instr(table, index, resource);
+  case TokenKind::INC_INST:
+    return make_inc_instr(table, index, resource);
+  case TokenKind::DEC_INST:
+    return make_dec_instr(table, index, resource);
+  case TokenKind::BE_INST:
+    return make_be_instr(table, index, symbols, resource);
+  case TokenKind::BN_INST:
+    return make_bn_instr(table, index, symbols, resource);
+  case TokenKind::BG_INST:
+    return make_bg_instr(table, index, symbols, resource);
+  case TokenKind::BS_INST:
+    return make_bs_instr(table, index, symbols, resource);
+  case TokenKind::BGE_INST:
+    return make_bge_instr(table, index, symbols, resource);
+  case TokenKind::BSE_INST:
+    return make_bse_instr(table, index, symbols, resource);
+  case TokenKind::LABEL:
+    return make_label(table, index, symbols, resource);
+  default:
+    throw std::runtime_error("Token inconnu.");
+  }
+}
+
 } // namespace detail
 
 } // namespace fnt
@@ -1,4 +1,12 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <front/metrics.hpp>
 #include <front/source.hpp>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
 
 namespace cmp {
 
@@ -6,39 +14,140 @@ namespace fnt {
 
 namespace detail {
 
-std::ifstream try_open_source_file(std::string filename) {
-  auto file_handler = std::ifstream(filename);
-
-  if (not file_handler.is_open())
-    throw std::runtime_error("Source file could not be open.");
-
-  return file_handler;
+std::pmr::string read_source_file(int fd,
+                                  std::pmr::memory_resource *resource) {
+  constexpr std::size_t chunk_size = 1 << 16;
+  auto res = std::pmr::string{resource};
+  std::size_t size = 0;
+
+  for (;;) {
+    res.resize(size + chunk_size);
+    auto bytes = ::read(fd, res.data() + size, chunk_size);
+
+    if (bytes > 0)
+      size += static_cast<std::size_t>(bytes);
+    else if (bytes == 0)
+      break;
+    else if (errno != EINTR)
+      throw std::runtime_error("Source file could not be read.");
+  }
+
+  res.resize(size);
+  return res;
 }
 
-std::string convert_source_to_text(std::ifstream &file_handler) {
-  auto res = std::string{};
-  auto line = std::string{};
+std::pmr::string convert_source_to_text(std::istream &file_handler,
+                                        std::pmr::memory_resource *resource) {
+  auto res = std::pmr::string{resource};
+  auto line = std::pmr::string{resource};
 
-  while (std::getline(file_handler, line))
-    res.append(line + " ");
+  while (std::getline(file_handler, line)) {
+    res.append(line);
+    res.push_back('\n');
+  }
 
   return res;
 }
 
 } // namespace detail
 
-TextSource TextSource::from_file(std::string filename) {
-  auto res = TextSource{};
+TextSource::TextSource(std::pmr::memory_resource *resource)
+    : _text_source(resource) {}
+
+TextSource::TextSource(TextSource &&other) noexcept
+    : _text_source(std::move(other._text_source)),
+      _mapped_data(std::exchange(other._mapped_data, nullptr)),
+      _mapped_size(std::exchange(other._mapped_size, 0)) {}
+
+TextSource &TextSource::operator=(TextSource &&other) noexcept {
+  if (this != &other) {
+    release();
+    _text_source = std::move(other._text_source);
+    _mapped_data = std::exchange(other._mapped_data, nullptr);
+    _mapped_size = std::exchange(other._mapped_size, 0);
+  }
+
+  return *this;
+}
+
+TextSource::~TextSource() { release(); }
+
+void TextSource::release() {
+  if (_mapped_data != nullptr)
+    ::munmap(const_cast<char *>(_mapped_data), _mapped_size);
+
+  _mapped_data = nullptr;
+  _mapped_size = 0;
+}
 
-  auto file_handler = detail::try_open_source_file(std::move(filename));
-  res._text_source = std::move(detail::convert_source_to_text(file_handler));
+TextSource TextSource::from_file(std::string filename,
+                                 std::pmr::memory_resource *resource) {
+  if (filename == "-")
+    return from_stream(std::cin, resource);
 
-  file_handler.close();
+  auto timer = PhaseTimer{Phase::FILE_READ};
+  auto res = TextSource{resource};
+
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Source file could not be open.");
+
+  struct stat info;
+  if (::fstat(fd, &info) == 0 and S_ISREG(info.st_mode)) {
+    if (info.st_size == 0) {
+      ::close(fd);
+      return res;
+    }
+
+    auto size = static_cast<std::size_t>(info.st_size);
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED) {
+      ::madvise(data, size, MADV_SEQUENTIAL);
+      ::close(fd);
+
+      res._mapped_data = static_cast<char const *>(data);
+      res._mapped_size = size;
+      count(Counter::BYTES, size);
+
+      return res;
+    }
+  }
+
+  // Pipes, character devices or unmappable files are read from the same
+  // descriptor: opening them again would lose what a writer already sent to a
+  // FIFO, or wait forever for a new writer.
+  try {
+    res._text_source = detail::read_source_file(fd, resource);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+  count(Counter::BYTES, res._text_source.size());
 
   return res;
 }
 
-std::string const &TextSource::get_text() const { return _text_source; }
+TextSource TextSource::from_stream(std::istream &stream,
+                                   std::pmr::memory_resource *resource) {
+  auto timer = PhaseTimer{Phase::FILE_READ};
+  auto res = TextSource{resource};
+
+  res._text_source = detail::convert_source_to_text(stream, resource);
+  count(Counter::BYTES, res._text_source.size());
+
+  return res;
+}
+
+std::string_view TextSource::get_text() const {
+  if (_mapped_data != nullptr)
+    return {_mapped_data, _mapped_size};
+
+  return _text_source;
+}
+
+bool TextSource::is_mapped() const { return _mapped_data != nullptr; }
 
 } // namespace fnt
 
@@ -0,0 +1,58 @@
+#include <front/stream.hpp>
+#include <string_view>
+
+namespace cmp {
+
+namespace fnt {
+
+StreamLexer::StreamLexer(std::istream &input, std::size_t chunk_size)
+    : _input(input), _chunk(chunk_size > 0 ? chunk_size : 1) {}
+
+bool StreamLexer::refill() {
+  _input.read(_chunk.data(), static_cast<std::streamsize>(_chunk.size()));
+
+  _position = 0;
+  _end = static_cast<std::size_t>(_input.gcount());
+
+  return _end > 0;
+}
+
+std::optional<Token> StreamLexer::next() {
+  _spanning_word.clear();
+
+  // Skips white characters, possibly over several chunks.
+  for (;;) {
+    while (_position < _end and detail::is_white_character(_chunk[_position]))
+      ++_position;
+
+    if (_position < _end)
+      break;
+
+    if (not refill())
+      return std::nullopt;
+  }
+
+  for (;;) {
+    auto start = _position;
+    while (_position < _end and
+           not detail::is_white_character(_chunk[_position]))
+      ++_position;
+
+    auto part = std::string_view{_chunk.data() + start, _position - start};
+
+    // Words lying in a single chunk are handed out without any copy.
+    if (_position < _end and _spanning_word.empty())
+      return Token{part, detail::tokenize_word(part)};
+
+    _spanning_word.append(part);
+
+    if (_position < _end or not refill())
+      break;
+  }
+
+  return Token{_spanning_word, detail::tokenize_word(_spanning_word)};
+}
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
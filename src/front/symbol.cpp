@@ -0,0 +1,98 @@
+#include <front/symbol.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace fnt {
+
+SymbolTable::SymbolTable(std::pmr::memory_resource *resource)
+    : _names(resource), _ids(resource), _targets(resource),
+      _released(resource) {}
+
+SymbolTable::SymbolTable(SymbolTable const &other) { *this = other; }
+
+SymbolTable &SymbolTable::operator=(SymbolTable const &other) {
+  if (this == &other)
+    return *this;
+
+  // Keys view the names of the table, so they are rebuilt on the copies.
+  _names = other._names;
+  _targets = other._targets;
+  _released = other._released;
+
+  auto is_released = std::vector<bool>(_names.size(), false);
+  for (auto id : _released)
+    is_released[id] = true;
+
+  _ids.clear();
+  for (std::uint32_t id = 0; id < _names.size(); ++id)
+    if (not is_released[id])
+      _ids.emplace(_names[id], id);
+
+  return *this;
+}
+
+SymbolTable &SymbolTable::operator=(SymbolTable &&other) {
+  if (this == &other)
+    return *this;
+
+  // Names moved between resources are reallocated, and the keys viewing them
+  // would dangle.
+  if (_names.get_allocator() != other._names.get_allocator())
+    return *this = other;
+
+  _names = std::move(other._names);
+  _ids = std::move(other._ids);
+  _targets = std::move(other._targets);
+  _released = std::move(other._released);
+
+  return *this;
+}
+
+std::uint32_t SymbolTable::intern(std::string_view name) {
+  if (auto it = _ids.find(name); it != _ids.end())
+    return it->second;
+
+  if (not _released.empty()) {
+    auto id = _released.back();
+    _released.pop_back();
+    _names[id] = name;
+    _ids.emplace(_names[id], id);
+    return id;
+  }
+
+  auto id = static_cast<std::uint32_t>(_names.size());
+  _names.emplace_back(name);
+  _targets.push_back(NO_TARGET);
+  _ids.emplace(_names.back(), id);
+
+  return id;
+}
+
+std::optional<std::uint32_t> SymbolTable::find(std::string_view name) const {
+  if (auto it = _ids.find(name); it != _ids.end())
+    return it->second;
+
+  return std::nullopt;
+}
+
+void SymbolTable::define(std::uint32_t id, std::size_t index) {
+  if (_targets[id] != NO_TARGET)
+    throw std::runtime_error("Label defined twice: " +
+                             std::string{_names[id]});
+
+  _targets[id] = index;
+}
+
+void SymbolTable::release(std::uint32_t id) {
+  _ids.erase(_names[id]);
+  _names[id].clear();
+  _targets[id] = NO_TARGET;
+  _released.push_back(id);
+}
+
+} // namespace fnt
+
+} // namespace cmp
\ No newline at end of file
@@ -1,10 +1,23 @@
+#include <front/metrics.hpp>
+#include <front/mnemonic.hpp>
 #include <front/token.hpp>
-#include <iostream>
-#include <regex>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CMP_X86
+#endif
+
 namespace cmp {
 
 namespace fnt {
@@ -18,99 +31,415 @@ bool is_white_character(char c) {
   return false;
 }
 
-std::string left_trim(std::string const &word) {
-  std::string const WHITESPACE = " \n\r\t\f\v";
-  size_t start = word.find_first_not_of(WHITESPACE);
+namespace {
+
+constexpr std::size_t BLOCK_SIZE = 64;
+// Masks are computed for this many blocks at once, then scanned.
+constexpr std::size_t BATCH_BLOCKS = 64;
+
+using white_masks_type = void (*)(char const *text, std::size_t block_count,
+                                  std::uint64_t *masks);
+
+void push_word(std::string_view text, std::size_t begin, std::size_t end,
+               TokenTable::token_type &res, SampledTimer &classification) {
+  auto word = text.substr(begin, end - begin);
+  auto kind = classification.time([word] { return tokenize_word(word); });
+  res.push_back(kind, begin, word.size());
+}
+
+void extract_words_scalar(std::string_view text, std::size_t begin,
+                          std::size_t end, TokenTable::token_type &res,
+                          SampledTimer &classification) {
+  std::size_t start = begin;
+  bool in_word = false;
+
+  for (std::size_t i = begin; i < end; ++i) {
+    if (is_white_character(text[i])) {
+      if (in_word) {
+        push_word(text, start, i, res, classification);
+        in_word = false;
+      }
+    } else if (not in_word) {
+      start = i;
+      in_word = true;
+    }
+  }
+
+  // The range does not necessarily end with a white character.
+  if (in_word)
+    push_word(text, start, end, res, classification);
+}
+
+/*
+ * Gets the mask of the white characters of a block shorter than BLOCK_SIZE.
+ * Bits past its end are set, as if the text went on with white characters.
+ */
+std::uint64_t tail_white_mask(char const *text, std::size_t size) {
+  std::uint64_t res = ~std::uint64_t{0} << size;
+
+  for (std::size_t i = 0; i < size; ++i)
+    res |= std::uint64_t{is_white_character(text[i])} << i;
+
+  return res;
+}
+
+#ifdef CMP_X86
+
+// A byte is white if it is at most 32 as an unsigned value: it is then equal
+// to its minimum with 32.
+
+__attribute__((target("sse2"))) void
+white_masks_sse2(char const *text, std::size_t block_count,
+                 std::uint64_t *masks) {
+  auto const limit = _mm_set1_epi8(32);
+
+  for (std::size_t i = 0; i < block_count; ++i) {
+    std::uint64_t mask = 0;
+
+    for (std::size_t k = 0; k < BLOCK_SIZE / 16; ++k) {
+      auto bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(
+          text + i * BLOCK_SIZE + k * 16));
+      auto white = _mm_cmpeq_epi8(_mm_min_epu8(bytes, limit), bytes);
+      mask |= std::uint64_t{static_cast<std::uint16_t>(
+                  _mm_movemask_epi8(white))}
+              << (k * 16);
+    }
+
+    masks[i] = mask;
+  }
+}
+
+__attribute__((target("avx2"))) void
+white_masks_avx2(char const *text, std::size_t block_count,
+                 std::uint64_t *masks) {
+  auto const limit = _mm256_set1_epi8(32);
+
+  for (std::size_t i = 0; i < block_count; ++i) {
+    auto low = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const *>(text + i * BLOCK_SIZE));
+    auto high = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const *>(text + i * BLOCK_SIZE + 32));
+    auto low_white = _mm256_cmpeq_epi8(_mm256_min_epu8(low, limit), low);
+    auto high_white = _mm256_cmpeq_epi8(_mm256_min_epu8(high, limit), high);
+
+    masks[i] = std::uint64_t{static_cast<std::uint32_t>(
+                   _mm256_movemask_epi8(low_white))} |
+               std::uint64_t{static_cast<std::uint32_t>(
+                   _mm256_movemask_epi8(high_white))}
+                   << 32;
+  }
+}
+
+#endif
 
-  if (start != std::string::npos)
-    return word.substr(start);
-  else
-    return "";
+/*
+ * Finds words from the masks of the white characters of the text. A word
+ * starts or ends wherever a character is not of the same kind as the one
+ * before it, so the boundaries are the set bits of the mask xored with itself
+ * shifted by one, which are walked with a count of trailing zeros.
+ */
+void extract_words_by_blocks(std::string_view text, std::size_t begin,
+                             std::size_t end, TokenTable::token_type &res,
+                             white_masks_type white_masks,
+                             SampledTimer &classification) {
+  auto masks = std::array<std::uint64_t, BATCH_BLOCKS>{};
+  std::size_t start = begin;
+  bool in_word = false;
+  std::size_t base = begin;
+
+  while (base < end) {
+    // Only whole blocks are loaded, so that no byte past the text is read.
+    auto block_count = std::min(BATCH_BLOCKS, (end - base) / BLOCK_SIZE);
+    if (block_count > 0) {
+      white_masks(text.data() + base, block_count, masks.data());
+    } else {
+      masks[0] = tail_white_mask(text.data() + base, end - base);
+      block_count = 1;
+    }
+
+    for (std::size_t i = 0; i < block_count; ++i) {
+      auto words = ~masks[i];
+      auto boundaries = words ^ ((words << 1) | std::uint64_t{in_word});
+
+      while (boundaries != 0) {
+        auto position =
+            base + i * BLOCK_SIZE +
+            static_cast<std::size_t>(std::countr_zero(boundaries));
+
+        if (in_word)
+          push_word(text, start, position, res, classification);
+        else
+          start = position;
+
+        in_word = not in_word;
+        boundaries &= boundaries - 1;
+      }
+    }
+
+    base = std::min(end, base + block_count * BLOCK_SIZE);
+  }
+
+  // A word ending the last whole block is only closed here.
+  if (in_word)
+    push_word(text, start, end, res, classification);
+}
+
+} // namespace
+
+bool is_supported(WordSplitter splitter) {
+  switch (splitter) {
+  case WordSplitter::SCALAR:
+    return true;
+#ifdef CMP_X86
+  case WordSplitter::SSE2:
+    return __builtin_cpu_supports("sse2");
+  case WordSplitter::AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+WordSplitter best_word_splitter() {
+  static auto const res = [] {
+#ifdef CMP_X86
+    __builtin_cpu_init();
+#endif
+
+    for (auto splitter : {WordSplitter::AVX2, WordSplitter::SSE2})
+      if (is_supported(splitter))
+        return splitter;
+
+    return WordSplitter::SCALAR;
+  }();
+
+  return res;
+}
+
+void extract_words(std::string_view text, std::size_t begin, std::size_t end,
+                   TokenTable::token_type &res) {
+  extract_words(text, begin, end, res, best_word_splitter());
+}
+
+void extract_words(std::string_view text, std::size_t begin, std::size_t end,
+                   TokenTable::token_type &res, WordSplitter splitter) {
+  auto timer = PhaseTimer{Phase::WORD_EXTRACTION};
+  auto classification = SampledTimer{Phase::CLASSIFICATION};
+  auto initial_size = res.size();
+
+  switch (splitter) {
+#ifdef CMP_X86
+  case WordSplitter::SSE2:
+    extract_words_by_blocks(text, begin, end, res, white_masks_sse2,
+                            classification);
+    break;
+  case WordSplitter::AVX2:
+    extract_words_by_blocks(text, begin, end, res, white_masks_avx2,
+                            classification);
+    break;
+#endif
+  default:
+    extract_words_scalar(text, begin, end, res, classification);
+    break;
+  }
+
+  count(Counter::TOKENS, res.size() - initial_size);
 }
 
 TokenTable::token_type
 extract_words_from_text_source(const TextSource &text_source) {
-  auto res = TokenTable::token_type{};
-  auto word = std::string{};
-
-  for (auto &&c : text_source.get_text()) {
-    if (is_white_character(c) and not word.empty()) {
-      word = std::move(left_trim(word));
-      res.emplace_back(word, tokenize_word(word));
-      word.clear();
-    } else if (not is_white_character(c))
-      word.push_back(c);
+  auto text = text_source.get_text();
+  auto res = TokenTable::token_type{text};
+
+  if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    throw std::runtime_error("Source text is too large.");
+
+  extract_words(text, 0, text.size(), res);
+
+  return res;
+}
+
+TokenTable::token_type
+extract_words_from_text_source(const TextSource &text_source,
+                               ThreadPool &pool) {
+  auto text = text_source.get_text();
+  auto chunk_count = std::min(pool.size(), text.size() / MIN_CHUNK_SIZE);
+
+  if (chunk_count <= 1)
+    return extract_words_from_text_source(text_source);
+
+  if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    throw std::runtime_error("Source text is too large.");
+
+  // Chunks end right after a line break, so that no word is split.
+  auto bounds = std::vector<std::size_t>{0};
+  for (std::size_t i = 1; i < chunk_count; ++i) {
+    auto bound = text.find('\n', std::max(bounds.back(),
+                                          text.size() / chunk_count * i));
+    if (bound == std::string_view::npos)
+      break;
+    bounds.push_back(bound + 1);
   }
+  bounds.push_back(text.size());
+
+  auto chunks = std::vector<TokenTable::token_type>(
+      bounds.size() - 1, TokenTable::token_type{text});
+  auto errors = std::vector<std::exception_ptr>(chunks.size());
+
+  // Pool tasks must not throw, so errors are carried back to the caller.
+  for (std::size_t i = 0; i < chunks.size(); ++i)
+    pool.submit([&, i](std::size_t) {
+      try {
+        extract_words(text, bounds[i], bounds[i + 1], chunks[i]);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  pool.wait();
+
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+
+  std::size_t token_count = 0;
+  for (auto const &chunk : chunks)
+    token_count += chunk.size();
+
+  auto res = std::move(chunks[0]);
+  res.reserve(token_count);
+  for (std::size_t i = 1; i < chunks.size(); ++i)
+    res.append(chunks[i]);
 
   return res;
 }
 
-bool is_instruction(std::string word) {
-  if (word == "br" or word == "ld" or word == "str" or word == "out" or
-      word == "add" or word == "sub" or word == "mul" or word == "div" or
-      word == "inc" or word == "dec" or word == "be" or word == "bn" or
-      word == "bg" or word == "bs" or word == "bge" or word == "bse")
-    return true;
+bool is_instruction(std::string_view word) {
+  return find_mnemonic(word) != TokenKind::_UNKNOWN;
+}
 
-  return false;
+TokenKind parse_instruction(std::string_view word) {
+  return find_mnemonic(word);
 }
 
-TokenKind parse_instruction(std::string word) {
-  if (word == "br")
-    return TokenKind::BR_INST;
-  else if (word == "ld")
-    return TokenKind::LD_INST;
-  else if (word == "str")
-    return TokenKind::STR_INST;
-  else if (word == "out")
-    return TokenKind::OUT_INST;
-  else if (word == "add")
-    return TokenKind::ADD_INST;
-  else if (word == "sub")
-    return TokenKind::SUB_INST;
-  else if (word == "mul")
-    return TokenKind::MUL_INST;
-  else if (word == "div")
-    return TokenKind::DIV_INST;
-  else if (word == "inc")
-    return TokenKind::INC_INST;
-  else if (word == "dec")
-    return TokenKind::DEC_INST;
-  else if (word == "be")
-    return TokenKind::BE_INST;
-  else if (word == "bn")
-    return TokenKind::BN_INST;
-  else if (word == "bg")
-    return TokenKind::BG_INST;
-  else if (word == "bs")
-    return TokenKind::BS_INST;
-  else if (word == "bge")
-    return TokenKind::BGE_INST;
-  else if (word == "bse")
-    return TokenKind::BSE_INST;
-  else
-    return TokenKind::_UNKNOWN;
-}
-
-TokenKind tokenize_word(std::string word) {
-  auto int_lit = std::regex("^[1-9][0-9]*|0$");
-  auto reg = std::regex("^r[0-9]$");
-  auto label = std::regex("^[a-zA-Z_$][a-zA-Z_$0-9]*$");
-
-  if (is_instruction(word))
-    return parse_instruction(word);
-  if (std::regex_match(std::move(word), int_lit)) {
-    return TokenKind::INT_LIT;
-  } else if (std::regex_match(std::move(word), reg))
-    return TokenKind::REGISTER;
-  else if (std::regex_match(std::move(word), label))
-    return TokenKind::LABEL;
-  else
-    return TokenKind::_UNKNOWN;
+namespace {
+
+/*
+ * Character classes and states of the word automaton. A word is read byte by
+ * byte, and the state reached at its end gives its meaning.
+ */
+enum CharClass : std::uint8_t {
+  C_OTHER,
+  C_ZERO,
+  C_NONZERO,
+  C_R,
+  C_ALPHA,
+  CHAR_CLASS_COUNT,
+};
+
+enum State : std::uint8_t {
+  S_START,
+  S_ZERO,
+  S_INT,
+  S_R,
+  S_REG,
+  S_LABEL,
+  S_DEAD,
+  STATE_COUNT,
+};
+
+constexpr auto CHAR_CLASSES = [] {
+  auto res = std::array<std::uint8_t, 256>{};
+
+  for (int c = 0; c < 256; ++c) {
+    if (c == '0')
+      res[c] = C_ZERO;
+    else if ('1' <= c and c <= '9')
+      res[c] = C_NONZERO;
+    else if (c == 'r')
+      res[c] = C_R;
+    else if (('a' <= c and c <= 'z') or ('A' <= c and c <= 'Z') or c == '_' or
+             c == '$')
+      res[c] = C_ALPHA;
+    else
+      res[c] = C_OTHER;
+  }
+
+  return res;
+}();
+
+constexpr std::uint8_t TRANSITIONS[STATE_COUNT][CHAR_CLASS_COUNT] = {
+    //           other   '0'      [1-9]    'r'      alpha
+    /* START */ {S_DEAD, S_ZERO, S_INT, S_R, S_LABEL},
+    /* ZERO  */ {S_DEAD, S_DEAD, S_DEAD, S_DEAD, S_DEAD},
+    /* INT   */ {S_DEAD, S_INT, S_INT, S_DEAD, S_DEAD},
+    /* R     */ {S_DEAD, S_REG, S_REG, S_LABEL, S_LABEL},
+    /* REG   */ {S_DEAD, S_LABEL, S_LABEL, S_LABEL, S_LABEL},
+    /* LABEL */ {S_DEAD, S_LABEL, S_LABEL, S_LABEL, S_LABEL},
+    /* DEAD  */ {S_DEAD, S_DEAD, S_DEAD, S_DEAD, S_DEAD},
+};
+
+constexpr TokenKind ACCEPTED[STATE_COUNT] = {
+    TokenKind::_UNKNOWN, TokenKind::INT_LIT, TokenKind::INT_LIT,
+    TokenKind::LABEL,    TokenKind::REGISTER, TokenKind::LABEL,
+    TokenKind::_UNKNOWN,
+};
+
+} // namespace
+
+TokenKind tokenize_word(std::string_view word) {
+  std::uint8_t state = S_START;
+
+  for (auto &&c : word) {
+    state = TRANSITIONS[state][CHAR_CLASSES[static_cast<unsigned char>(c)]];
+    if (state == S_DEAD)
+      return TokenKind::_UNKNOWN;
+  }
+
+  if (state == S_LABEL) {
+    auto kind = parse_instruction(word);
+    if (kind != TokenKind::_UNKNOWN)
+      return kind;
+  }
+
+  return ACCEPTED[state];
 }
 
 } // namespace detail
 
+TokenArray::TokenArray(std::string_view source,
+                       std::pmr::memory_resource *resource)
+    : _source(source), _kinds(resource), _offsets(resource),
+      _lengths(resource) {}
+
+void TokenArray::push_back(TokenKind kind, std::size_t offset,
+                           std::size_t length) {
+  _kinds.push_back(kind);
+  _offsets.push_back(static_cast<std::uint32_t>(offset));
+  _lengths.push_back(static_cast<std::uint32_t>(length));
+}
+
+void TokenArray::append(TokenArray const &other) {
+  _kinds.insert(_kinds.end(), other._kinds.begin(), other._kinds.end());
+  _offsets.insert(_offsets.end(), other._offsets.begin(), other._offsets.end());
+  _lengths.insert(_lengths.end(), other._lengths.begin(), other._lengths.end());
+}
+
+void TokenArray::reserve(std::size_t count) {
+  _kinds.reserve(count);
+  _offsets.reserve(count);
+  _lengths.reserve(count);
+}
+
+void TokenArray::reset(std::string_view source) {
+  _source = source;
+  _kinds.clear();
+  _offsets.clear();
+  _lengths.clear();
+}
+
+TokenTable::TokenTable(token_type &&tokens) : _token_table(std::move(tokens)) {}
+
 TokenTable TokenTable::from_text_source(const TextSource &text_source) {
   auto res = TokenTable{};
 
@@ -120,10 +449,44 @@ TokenTable TokenTable::from_text_source(const TextSource &text_source) {
   return res;
 }
 
+TokenTable TokenTable::from_text_source(const TextSource &text_source,
+                                        std::pmr::memory_resource *resource) {
+  return from_text_source(text_source,
+                          token_type{text_source.get_text(), resource});
+}
+
+TokenTable TokenTable::from_text_source(const TextSource &text_source,
+                                        ThreadPool &pool) {
+  auto res = TokenTable{};
+
+  res._token_table = detail::extract_words_from_text_source(text_source, pool);
+
+  return res;
+}
+
+TokenTable TokenTable::from_text_source(const TextSource &text_source,
+                                        token_type &&buffer) {
+  auto text = text_source.get_text();
+
+  if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    throw std::runtime_error("Source text is too large.");
+
+  // Moving the buffer into the table keeps its memory resource.
+  auto res = TokenTable{std::move(buffer)};
+  res._token_table.reset(text);
+  detail::extract_words(text, 0, text.size(), res._token_table);
+
+  return res;
+}
+
 TokenTable::token_type const &TokenTable::get_table() const {
   return _token_table;
 }
 
+TokenTable::token_type TokenTable::release() {
+  return std::move(_token_table);
+}
+
 } // namespace fnt
 
 } // namespace cmp
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <opt/cfg.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace opt {
+
+namespace {
+
+void add_edge(std::vector<BasicBlock> &blocks, std::uint32_t from,
+              std::uint32_t to) {
+  auto &successors = blocks[from].successors;
+  if (std::find(successors.begin(), successors.end(), to) != successors.end())
+    return;
+
+  successors.push_back(to);
+  blocks[to].predecessors.push_back(from);
+}
+
+/**
+ * Iterative depth-first search from the entry, since programs may have
+ * millions of blocks. A block is visited along with its parent in the search
+ * tree, and finished once all its successors are.
+ */
+template <typename Visit, typename Finish>
+void depth_first_search(std::vector<BasicBlock> const &blocks, Visit visit,
+                        Finish finish) {
+  auto visited = std::vector<bool>(blocks.size(), false);
+  auto stack = std::vector<std::pair<std::uint32_t, std::size_t>>{{0, 0}};
+  visited[0] = true;
+  visit(0, NO_BLOCK);
+
+  while (not stack.empty()) {
+    auto [block, next] = stack.back();
+    auto const &successors = blocks[block].successors;
+
+    if (next < successors.size()) {
+      ++stack.back().second;
+      auto successor = successors[next];
+      if (not visited[successor]) {
+        visited[successor] = true;
+        visit(successor, block);
+        stack.emplace_back(successor, 0);
+      }
+    } else {
+      finish(block);
+      stack.pop_back();
+    }
+  }
+}
+
+} // namespace
+
+ControlFlowGraph
+ControlFlowGraph::from_dense_program(fnt::DenseProgram const &program) {
+  auto res = ControlFlowGraph{};
+  auto const &symbols = program.get_symbols();
+  auto block_of = std::vector<std::uint32_t>(program.size());
+
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    auto opcode = program[i].opcode;
+    bool leader = i == 0 or opcode == fnt::Opcode::LABEL or
+                  fnt::is_branch(program[i - 1].opcode);
+
+    if (leader) {
+      if (not res._blocks.empty())
+        res._blocks.back().end = i;
+      res._blocks.push_back({i, program.size(), {}, {}});
+    }
+    block_of[i] = static_cast<std::uint32_t>(res._blocks.size() - 1);
+  }
+
+  auto count = static_cast<std::uint32_t>(res._blocks.size());
+  for (std::uint32_t block = 0; block < count; ++block) {
+    auto const &last = program[res._blocks[block].end - 1];
+
+    if (fnt::is_branch(last.opcode)) {
+      auto target = symbols.target(last.label());
+      if (target == fnt::SymbolTable::NO_TARGET)
+        throw std::runtime_error("Undefined label: " +
+                                 std::string{symbols.name(last.label())});
+      add_edge(res._blocks, block, block_of[target]);
+    }
+
+    if (last.opcode != fnt::Opcode::BR and block + 1 < count)
+      add_edge(res._blocks, block, block + 1);
+  }
+
+  res.compute_order();
+  res.compute_dominators();
+  res.compute_loops();
+
+  return res;
+}
+
+std::vector<BasicBlock> const &ControlFlowGraph::get_blocks() const {
+  return _blocks;
+}
+
+std::vector<std::uint32_t> const &ControlFlowGraph::reverse_postorder() const {
+  return _reverse_postorder;
+}
+
+bool ControlFlowGraph::is_reachable(std::uint32_t block) const {
+  return _order[block] != NO_BLOCK;
+}
+
+std::uint32_t ControlFlowGraph::immediate_dominator(std::uint32_t block) const {
+  return _idom[block];
+}
+
+bool ControlFlowGraph::dominates(std::uint32_t dominator,
+                                 std::uint32_t block) const {
+  if (not is_reachable(dominator) or not is_reachable(block))
+    return false;
+
+  return _preorder[dominator] <= _preorder[block] and
+         _postorder[block] <= _postorder[dominator];
+}
+
+std::vector<Loop> const &ControlFlowGraph::get_loops() const { return _loops; }
+
+std::uint32_t ControlFlowGraph::loop_of(std::uint32_t block) const {
+  return _loop_of[block];
+}
+
+bool ControlFlowGraph::contains(std::uint32_t loop, std::uint32_t block) const {
+  for (auto inner = _loop_of[block]; inner != NO_LOOP;
+       inner = _loops[inner].parent) {
+    if (inner == loop)
+      return true;
+  }
+  return false;
+}
+
+std::uint32_t ControlFlowGraph::loop_depth(std::uint32_t block) const {
+  auto loop = _loop_of[block];
+  return loop == NO_LOOP ? 0 : _loops[loop].depth;
+}
+
+void ControlFlowGraph::compute_order() {
+  _order.assign(_blocks.size(), NO_BLOCK);
+  if (_blocks.empty())
+    return;
+
+  depth_first_search(
+      _blocks, [](std::uint32_t, std::uint32_t) {},
+      [&](std::uint32_t block) { _reverse_postorder.push_back(block); });
+
+  std::reverse(_reverse_postorder.begin(), _reverse_postorder.end());
+  for (std::size_t i = 0; i < _reverse_postorder.size(); ++i)
+    _order[_reverse_postorder[i]] = static_cast<std::uint32_t>(i);
+}
+
+void ControlFlowGraph::compute_dominators() {
+  // Lengauer and Tarjan, "A Fast Algorithm for Finding Dominators in a
+  // Flowgraph", with path compression. Blocks are numbered in depth-first
+  // preorder, and the iterative algorithms can walk long chains of idoms on
+  // deep loop nests.
+  _idom.assign(_blocks.size(), NO_BLOCK);
+  if (_blocks.empty())
+    return;
+
+  auto number = std::vector<std::uint32_t>(_blocks.size(), NO_BLOCK);
+  auto vertex = std::vector<std::uint32_t>{};
+  auto parent = std::vector<std::uint32_t>{};
+  depth_first_search(
+      _blocks,
+      [&](std::uint32_t block, std::uint32_t from) {
+        number[block] = static_cast<std::uint32_t>(vertex.size());
+        vertex.push_back(block);
+        parent.push_back(from == NO_BLOCK ? NO_BLOCK : number[from]);
+      },
+      [](std::uint32_t) {});
+
+  auto count = static_cast<std::uint32_t>(vertex.size());
+  auto semi = std::vector<std::uint32_t>(count);
+  auto idom = std::vector<std::uint32_t>(count, NO_BLOCK);
+  auto ancestor = std::vector<std::uint32_t>(count, NO_BLOCK);
+  auto label = std::vector<std::uint32_t>(count);
+  auto bucket = std::vector<std::uint32_t>(count, NO_BLOCK);
+  auto next = std::vector<std::uint32_t>(count, NO_BLOCK);
+  auto path = std::vector<std::uint32_t>{};
+
+  for (std::uint32_t v = 0; v < count; ++v) {
+    semi[v] = v;
+    label[v] = v;
+  }
+
+  auto eval = [&](std::uint32_t v) {
+    if (ancestor[v] == NO_BLOCK)
+      return v;
+
+    for (auto u = v; ancestor[ancestor[u]] != NO_BLOCK; u = ancestor[u])
+      path.push_back(u);
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      auto u = *it;
+      if (semi[label[ancestor[u]]] < semi[label[u]])
+        label[u] = label[ancestor[u]];
+      ancestor[u] = ancestor[ancestor[u]];
+    }
+    path.clear();
+
+    return label[v];
+  };
+
+  for (auto w = count; w-- > 1;) {
+    for (auto predecessor : _blocks[vertex[w]].predecessors) {
+      if (number[predecessor] == NO_BLOCK)
+        continue;
+      auto u = eval(number[predecessor]);
+      semi[w] = std::min(semi[w], semi[u]);
+    }
+
+    next[w] = bucket[semi[w]];
+    bucket[semi[w]] = w;
+    ancestor[w] = parent[w];
+
+    for (auto v = bucket[parent[w]]; v != NO_BLOCK; v = next[v]) {
+      auto u = eval(v);
+      idom[v] = semi[u] < semi[v] ? u : parent[w];
+    }
+    bucket[parent[w]] = NO_BLOCK;
+  }
+
+  for (std::uint32_t w = 1; w < count; ++w) {
+    if (idom[w] != semi[w])
+      idom[w] = idom[idom[w]];
+    _idom[vertex[w]] = vertex[idom[w]];
+  }
+
+  // Numbers the dominator tree, so that dominance is an interval check.
+  auto first_child = std::vector<std::uint32_t>(_blocks.size(), NO_BLOCK);
+  auto next_sibling = std::vector<std::uint32_t>(_blocks.size(), NO_BLOCK);
+  for (auto block : _reverse_postorder) {
+    if (_idom[block] == NO_BLOCK)
+      continue;
+    next_sibling[block] = first_child[_idom[block]];
+    first_child[_idom[block]] = block;
+  }
+
+  _preorder.assign(_blocks.size(), 0);
+  _postorder.assign(_blocks.size(), 0);
+
+  std::uint32_t pre = 0;
+  std::uint32_t post = 0;
+  auto stack = std::vector<std::uint32_t>{0};
+  _preorder[0] = pre++;
+
+  while (not stack.empty()) {
+    auto block = stack.back();
+    auto child = first_child[block];
+
+    if (child != NO_BLOCK) {
+      first_child[block] = next_sibling[child];
+      _preorder[child] = pre++;
+      stack.push_back(child);
+    } else {
+      _postorder[block] = post++;
+      stack.pop_back();
+    }
+  }
+}
+
+void ControlFlowGraph::compute_loops() {
+  _loop_of.assign(_blocks.size(), NO_LOOP);
+
+  // Outermost loop found so far for each loop, with path halving, so that
+  // deep nests stay near-linear.
+  auto outer = std::vector<std::uint32_t>{};
+  auto outermost = [&](std::uint32_t loop) {
+    while (outer[loop] != loop) {
+      outer[loop] = outer[outer[loop]];
+      loop = outer[loop];
+    }
+    return loop;
+  };
+
+  // Headers are visited in reverse order, so that inner loops are found
+  // first. Walking back from the latches, a block already in a loop stands for
+  // its whole outermost loop, which becomes a child of the current one.
+  auto worklist = std::vector<std::uint32_t>{};
+  for (auto it = _reverse_postorder.rbegin(); it != _reverse_postorder.rend();
+       ++it) {
+    auto header = *it;
+    auto loop = Loop{header, NO_LOOP, 1, {}, {}};
+
+    for (auto predecessor : _blocks[header].predecessors) {
+      if (dominates(header, predecessor))
+        loop.latches.push_back(predecessor);
+    }
+    if (loop.latches.empty())
+      continue;
+
+    auto index = static_cast<std::uint32_t>(_loops.size());
+    _loop_of[header] = index;
+    loop.blocks.push_back(header);
+    worklist = loop.latches;
+    _loops.push_back(std::move(loop));
+    outer.push_back(index);
+
+    while (not worklist.empty()) {
+      auto block = worklist.back();
+      worklist.pop_back();
+
+      if (_loop_of[block] == NO_LOOP) {
+        _loop_of[block] = index;
+        _loops[index].blocks.push_back(block);
+        for (auto predecessor : _blocks[block].predecessors) {
+          if (is_reachable(predecessor))
+            worklist.push_back(predecessor);
+        }
+        continue;
+      }
+
+      auto inner = outermost(_loop_of[block]);
+      if (inner == index)
+        continue;
+
+      _loops[inner].parent = index;
+      outer[inner] = index;
+      for (auto predecessor : _blocks[_loops[inner].header].predecessors) {
+        if (is_reachable(predecessor) and
+            (_loop_of[predecessor] == NO_LOOP or
+             outermost(_loop_of[predecessor]) != index))
+          worklist.push_back(predecessor);
+      }
+    }
+  }
+
+  if (_loops.empty())
+    return;
+
+  // Puts enclosing loops first.
+  auto last = static_cast<std::uint32_t>(_loops.size() - 1);
+  std::reverse(_loops.begin(), _loops.end());
+  for (auto &loop : _loops) {
+    if (loop.parent != NO_LOOP) {
+      loop.parent = last - loop.parent;
+      loop.depth = _loops[loop.parent].depth + 1;
+    }
+  }
+  for (auto &loop : _loop_of) {
+    if (loop != NO_LOOP)
+      loop = last - loop;
+  }
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
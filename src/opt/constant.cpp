@@ -0,0 +1,264 @@
+#include <array>
+#include <opt/cfg.hpp>
+#include <opt/constant.hpp>
+#include <opt/pass.hpp>
+#include <utility>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace opt {
+
+namespace {
+
+/**
+ * Value of a register in the lattice: unknown yet (only in blocks not reached
+ * so far), a known constant, or varying.
+ */
+struct Value {
+  enum Kind : std::uint8_t { UNKNOWN, CONSTANT, VARYING };
+
+  Kind kind = UNKNOWN;
+  std::int32_t value = 0;
+
+  bool is_constant() const { return kind == CONSTANT; }
+
+  bool operator==(Value const &other) const {
+    return kind == other.kind and (kind != CONSTANT or value == other.value);
+  }
+};
+
+using Registers = std::array<Value, vm::REGISTER_COUNT>;
+
+Value constant(std::int32_t value) { return {Value::CONSTANT, value}; }
+
+Value const VARYING = {Value::VARYING, 0};
+
+/**
+ * Merges the registers flowing along an edge into the registers at the start
+ * of a block.
+ *
+ * @return true if the registers at the start of the block changed
+ */
+bool meet(Registers &into, Registers const &from) {
+  bool changed = false;
+
+  for (std::size_t i = 0; i < into.size(); ++i) {
+    auto merged = into[i];
+    if (from[i].kind == Value::UNKNOWN or into[i] == from[i])
+      continue;
+    if (into[i].kind == Value::UNKNOWN)
+      merged = from[i];
+    else
+      merged = VARYING;
+
+    if (not(merged == into[i])) {
+      into[i] = merged;
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+/**
+ * Computes the value written by an instruction, if it writes a register.
+ */
+Value result(fnt::DenseInstr const &instr, Registers const &r) {
+  auto const &lhs = r[instr.b];
+  auto const &rhs = r[instr.c];
+
+  switch (instr.opcode) {
+  case fnt::Opcode::LD:
+    return constant(instr.imm);
+  case fnt::Opcode::ADD:
+  case fnt::Opcode::SUB:
+  case fnt::Opcode::MUL:
+  case fnt::Opcode::DIV:
+    if (lhs.is_constant() and rhs.is_constant()) {
+      auto value = evaluate(instr.opcode, lhs.value, rhs.value);
+      return value ? constant(*value) : VARYING;
+    }
+    if (instr.opcode == fnt::Opcode::SUB and instr.b == instr.c)
+      return constant(0);
+    if (instr.opcode == fnt::Opcode::MUL and
+        ((lhs.is_constant() and lhs.value == 0) or
+         (rhs.is_constant() and rhs.value == 0)))
+      return constant(0);
+    return VARYING;
+  case fnt::Opcode::INC:
+  case fnt::Opcode::DEC:
+    if (not r[instr.a].is_constant())
+      return VARYING;
+    return constant(*evaluate(instr.opcode == fnt::Opcode::INC
+                                  ? fnt::Opcode::ADD
+                                  : fnt::Opcode::SUB,
+                              r[instr.a].value, 1));
+  default:
+    return r[instr.a];
+  }
+}
+
+bool writes_register(fnt::Opcode opcode) {
+  switch (opcode) {
+  case fnt::Opcode::LD:
+  case fnt::Opcode::ADD:
+  case fnt::Opcode::SUB:
+  case fnt::Opcode::MUL:
+  case fnt::Opcode::DIV:
+  case fnt::Opcode::INC:
+  case fnt::Opcode::DEC:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Outcome of the branch ending a block, when it is known.
+ */
+enum class Outcome { UNKNOWN, TAKEN, NOT_TAKEN };
+
+Outcome outcome(fnt::DenseInstr const &instr, Registers const &r) {
+  if (instr.opcode == fnt::Opcode::BR)
+    return Outcome::TAKEN;
+  if (not fnt::is_branch(instr.opcode))
+    return Outcome::NOT_TAKEN;
+
+  if (instr.a == instr.b)
+    return is_taken(instr.opcode, 0, 0) ? Outcome::TAKEN : Outcome::NOT_TAKEN;
+  if (r[instr.a].is_constant() and r[instr.b].is_constant())
+    return is_taken(instr.opcode, r[instr.a].value, r[instr.b].value)
+               ? Outcome::TAKEN
+               : Outcome::NOT_TAKEN;
+
+  return Outcome::UNKNOWN;
+}
+
+} // namespace
+
+fnt::DenseProgram propagate_constants(fnt::DenseProgram const &program,
+                                      ConstantStats &stats) {
+  auto cfg = ControlFlowGraph::from_dense_program(program);
+  auto entries = std::vector<Registers>(cfg.size());
+  auto reached = std::vector<bool>(cfg.size(), false);
+  auto queued = std::vector<bool>(cfg.size(), false);
+  auto worklist = std::vector<std::uint32_t>{};
+
+  stats = ConstantStats{};
+  stats.instructions_before = program.size();
+
+  auto fall_through = [&](std::uint32_t block) {
+    auto last = program[cfg[block].end - 1].opcode;
+    return last != fnt::Opcode::BR and block + 1 < cfg.size() ? block + 1
+                                                               : NO_BLOCK;
+  };
+
+  auto flow = [&](std::uint32_t block, Registers const &r) {
+    if (block == NO_BLOCK)
+      return;
+    bool changed = meet(entries[block], r);
+    if ((changed or not reached[block]) and not queued[block]) {
+      queued[block] = true;
+      worklist.push_back(block);
+    }
+    reached[block] = true;
+  };
+
+  if (not cfg.empty()) {
+    auto zeros = Registers{};
+    zeros.fill(constant(0));
+    flow(0, zeros);
+  }
+
+  // Every register changes kind at most twice, so the fixpoint is reached
+  // after a number of visits linear in the number of blocks.
+  while (not worklist.empty()) {
+    auto block = worklist.back();
+    worklist.pop_back();
+    queued[block] = false;
+
+    auto r = entries[block];
+    for (auto i = cfg[block].begin; i < cfg[block].end; ++i) {
+      if (writes_register(program[i].opcode))
+        r[program[i].a] = result(program[i], r);
+    }
+
+    auto const &last = program[cfg[block].end - 1];
+    auto decided = outcome(last, r);
+    if (fnt::is_branch(last.opcode) and decided != Outcome::NOT_TAKEN)
+      flow(cfg[block].successors[0], r);
+    if (decided != Outcome::TAKEN)
+      flow(fall_through(block), r);
+  }
+
+  // Block following each block once unreachable blocks are deleted, so that
+  // branches to it can be removed.
+  auto next = std::vector<std::uint32_t>(cfg.size(), NO_BLOCK);
+  for (auto block = cfg.size(); block-- > 1;)
+    next[block - 1] = reached[block] ? static_cast<std::uint32_t>(block)
+                                     : next[block];
+
+  auto code = fnt::DenseProgram::code_type{};
+  code.reserve(program.size());
+
+  for (std::uint32_t block = 0; block < cfg.size(); ++block) {
+    auto const &range = cfg[block];
+    if (not reached[block]) {
+      stats.unreachable_removed += range.end - range.begin;
+      continue;
+    }
+
+    auto r = entries[block];
+    for (auto i = range.begin; i < range.end; ++i) {
+      auto instr = program[i];
+
+      if (fnt::is_branch(instr.opcode)) {
+        auto decided = outcome(instr, r);
+        auto target = cfg[block].successors[0];
+        if (decided == Outcome::NOT_TAKEN or target == next[block]) {
+          ++stats.branches_removed;
+          continue;
+        }
+        if (decided == Outcome::TAKEN and instr.opcode != fnt::Opcode::BR) {
+          instr = {fnt::Opcode::BR, 0, 0, 0, instr.imm};
+          ++stats.branches_taken;
+        }
+        code.push_back(instr);
+        continue;
+      }
+
+      if (not writes_register(instr.opcode)) {
+        code.push_back(instr);
+        continue;
+      }
+
+      auto value = result(instr, r);
+      bool known = r[instr.a] == value and value.is_constant();
+      r[instr.a] = value;
+
+      if (known) {
+        ++stats.redundant_removed;
+        continue;
+      }
+      if (value.is_constant() and instr.opcode != fnt::Opcode::LD) {
+        instr = {fnt::Opcode::LD, instr.a, 0, 0, value.value};
+        ++stats.folded;
+      }
+      code.push_back(instr);
+    }
+  }
+
+  stats.instructions_after = code.size();
+
+  return replace_code(program, std::move(code));
+}
+
+fnt::DenseProgram propagate_constants(fnt::DenseProgram const &program) {
+  auto stats = ConstantStats{};
+  return propagate_constants(program, stats);
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <opt/cfg.hpp>
+#include <opt/dead.hpp>
+#include <opt/liveness.hpp>
+#include <opt/pass.hpp>
+#include <utility>
+
+namespace cmp {
+
+namespace opt {
+
+fnt::DenseProgram eliminate_dead_code(fnt::DenseProgram const &program,
+                                      DeadCodeStats &stats) {
+  auto cfg = ControlFlowGraph::from_dense_program(program);
+  auto liveness = Liveness::from_cfg(program, cfg);
+  auto dead = std::vector<bool>(program.size(), false);
+
+  stats = DeadCodeStats{};
+  stats.instructions_before = program.size();
+
+  for (std::uint32_t block = 0; block < cfg.size(); ++block) {
+    auto live = liveness.live_out(block);
+
+    for (auto i = cfg[block].end; i-- > cfg[block].begin;) {
+      dead[i] = is_dead(program[i], live);
+      live = live_before(program[i], live);
+    }
+  }
+
+  auto code = fnt::DenseProgram::code_type{};
+  code.reserve(program.size());
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    if (not dead[i])
+      code.push_back(program[i]);
+  }
+
+  stats.instructions_after = code.size();
+  stats.removed = stats.instructions_before - stats.instructions_after;
+
+  return replace_code(program, std::move(code));
+}
+
+fnt::DenseProgram eliminate_dead_code(fnt::DenseProgram const &program) {
+  auto stats = DeadCodeStats{};
+  return eliminate_dead_code(program, stats);
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <opt/liveness.hpp>
+
+namespace cmp {
+
+namespace opt {
+
+namespace {
+
+RegisterSet bit(std::uint8_t id) { return static_cast<RegisterSet>(1u << id); }
+
+} // namespace
+
+Liveness Liveness::from_cfg(fnt::DenseProgram const &program,
+                            ControlFlowGraph const &cfg) {
+  auto res = Liveness{};
+  res._live_in.assign(cfg.size(), 0);
+  res._live_out.assign(cfg.size(), 0);
+
+  // Reachable blocks are first visited in postorder, so that most of them are
+  // seen after their successors.
+  auto queued = std::vector<bool>(cfg.size(), true);
+  auto worklist = std::vector<std::uint32_t>{};
+  worklist.reserve(cfg.size());
+  for (std::uint32_t block = 0; block < cfg.size(); ++block) {
+    if (not cfg.is_reachable(block))
+      worklist.push_back(block);
+  }
+  auto const &order = cfg.reverse_postorder();
+  worklist.insert(worklist.end(), order.begin(), order.end());
+
+  while (not worklist.empty()) {
+    auto block = worklist.back();
+    worklist.pop_back();
+    queued[block] = false;
+
+    RegisterSet live = 0;
+    for (auto successor : cfg[block].successors)
+      live |= res._live_in[successor];
+    res._live_out[block] = live;
+
+    for (auto i = cfg[block].end; i-- > cfg[block].begin;)
+      live = live_before(program[i], live);
+
+    if (live == res._live_in[block])
+      continue;
+
+    res._live_in[block] = live;
+    for (auto predecessor : cfg[block].predecessors) {
+      if (not queued[predecessor]) {
+        queued[predecessor] = true;
+        worklist.push_back(predecessor);
+      }
+    }
+  }
+
+  return res;
+}
+
+RegisterSet uses(fnt::DenseInstr const &instr) {
+  switch (instr.opcode) {
+  case fnt::Opcode::STR:
+  case fnt::Opcode::OUT:
+  case fnt::Opcode::INC:
+  case fnt::Opcode::DEC:
+    return bit(instr.a);
+  case fnt::Opcode::ADD:
+  case fnt::Opcode::SUB:
+  case fnt::Opcode::MUL:
+  case fnt::Opcode::DIV:
+    return bit(instr.b) | bit(instr.c);
+  case fnt::Opcode::BE:
+  case fnt::Opcode::BN:
+  case fnt::Opcode::BG:
+  case fnt::Opcode::BS:
+  case fnt::Opcode::BGE:
+  case fnt::Opcode::BSE:
+    return bit(instr.a) | bit(instr.b);
+  default:
+    return 0;
+  }
+}
+
+RegisterSet defines(fnt::DenseInstr const &instr) {
+  switch (instr.opcode) {
+  case fnt::Opcode::LD:
+  case fnt::Opcode::ADD:
+  case fnt::Opcode::SUB:
+  case fnt::Opcode::MUL:
+  case fnt::Opcode::DIV:
+  case fnt::Opcode::INC:
+  case fnt::Opcode::DEC:
+    return bit(instr.a);
+  default:
+    return 0;
+  }
+}
+
+bool is_dead(fnt::DenseInstr const &instr, RegisterSet live) {
+  auto written = defines(instr);
+  return written != 0 and instr.opcode != fnt::Opcode::DIV and
+         (written & live) == 0;
+}
+
+RegisterSet live_before(fnt::DenseInstr const &instr, RegisterSet live) {
+  if (is_dead(instr, live))
+    return live;
+
+  return static_cast<RegisterSet>((live & ~defines(instr)) | uses(instr));
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
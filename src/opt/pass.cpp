@@ -0,0 +1,72 @@
+#include <limits>
+#include <opt/pass.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace opt {
+
+fnt::DenseProgram replace_code(fnt::DenseProgram const &program,
+                               fnt::DenseProgram::code_type code) {
+  auto const &old_symbols = program.get_symbols();
+  auto symbols = fnt::SymbolTable{};
+
+  // Ids are given in interning order, so they are kept.
+  for (std::uint32_t id = 0; id < old_symbols.size(); ++id)
+    symbols.intern(old_symbols.name(id));
+
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    if (code[i].opcode == fnt::Opcode::LABEL)
+      symbols.define(code[i].label(), i);
+  }
+
+  return fnt::DenseProgram::from_code(std::move(code), std::move(symbols));
+}
+
+std::optional<std::int32_t> evaluate(fnt::Opcode opcode, std::int32_t lhs,
+                                     std::int32_t rhs) {
+  auto l = static_cast<std::uint32_t>(lhs);
+  auto r = static_cast<std::uint32_t>(rhs);
+
+  switch (opcode) {
+  case fnt::Opcode::ADD:
+    return static_cast<std::int32_t>(l + r);
+  case fnt::Opcode::SUB:
+    return static_cast<std::int32_t>(l - r);
+  case fnt::Opcode::MUL:
+    return static_cast<std::int32_t>(l * r);
+  case fnt::Opcode::DIV:
+    if (rhs == 0)
+      return std::nullopt;
+    if (lhs == std::numeric_limits<std::int32_t>::min() and rhs == -1)
+      return lhs;
+    return lhs / rhs;
+  default:
+    throw std::runtime_error("Not an arithmetic operation.");
+  }
+}
+
+bool is_taken(fnt::Opcode opcode, std::int32_t lhs, std::int32_t rhs) {
+  switch (opcode) {
+  case fnt::Opcode::BE:
+    return lhs == rhs;
+  case fnt::Opcode::BN:
+    return lhs != rhs;
+  case fnt::Opcode::BG:
+    return lhs > rhs;
+  case fnt::Opcode::BS:
+    return lhs < rhs;
+  case fnt::Opcode::BGE:
+    return lhs >= rhs;
+  case fnt::Opcode::BSE:
+    return lhs <= rhs;
+  default:
+    throw std::runtime_error("Not a conditional branch.");
+  }
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <opt/pass.hpp>
+#include <opt/peephole.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cmp {
+
+namespace opt {
+
+namespace {
+
+using fnt::Opcode;
+
+bool ld_one_add(std::span<fnt::DenseInstr const> w, Replacement &res) {
+  auto const &ld = w[0];
+  auto const &add = w[1];
+  bool adds_one = (add.b == add.a and add.c == ld.a) or
+                  (add.c == add.a and add.b == ld.a);
+
+  if (ld.imm != 1 or add.a == ld.a or not adds_one)
+    return false;
+
+  res.push_back(ld);
+  res.push_back({Opcode::INC, add.a, 0, 0, 0});
+  return true;
+}
+
+bool ld_one_sub(std::span<fnt::DenseInstr const> w, Replacement &res) {
+  auto const &ld = w[0];
+  auto const &sub = w[1];
+
+  if (ld.imm != 1 or sub.a == ld.a or sub.b != sub.a or sub.c != ld.a)
+    return false;
+
+  res.push_back(ld);
+  res.push_back({Opcode::DEC, sub.a, 0, 0, 0});
+  return true;
+}
+
+bool inc_dec(std::span<fnt::DenseInstr const> w, Replacement &) {
+  return w[0].opcode != w[1].opcode and w[0].a == w[1].a;
+}
+
+bool branch_to_next(std::span<fnt::DenseInstr const> w, Replacement &res) {
+  if (w[0].label() != w[1].label())
+    return false;
+
+  res.push_back(w[1]);
+  return true;
+}
+
+Opcode invert(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::BE:
+    return Opcode::BN;
+  case Opcode::BN:
+    return Opcode::BE;
+  case Opcode::BG:
+    return Opcode::BSE;
+  case Opcode::BSE:
+    return Opcode::BG;
+  case Opcode::BS:
+    return Opcode::BGE;
+  case Opcode::BGE:
+    return Opcode::BS;
+  default:
+    throw std::runtime_error("Not a conditional branch.");
+  }
+}
+
+bool branch_over_br(std::span<fnt::DenseInstr const> w, Replacement &res) {
+  auto const &branch = w[0];
+
+  if (branch.label() != w[2].label())
+    return false;
+
+  res.push_back({invert(branch.opcode), branch.a, branch.b, 0, w[1].imm});
+  res.push_back(w[2]);
+  return true;
+}
+
+constexpr auto LABEL = opcodes({Opcode::LABEL});
+constexpr auto INC_DEC = opcodes({Opcode::INC, Opcode::DEC});
+
+PeepholeRule const DEFAULT_RULES[] = {
+    {"ld-one-add",
+     {opcodes({Opcode::LD}), opcodes({Opcode::ADD})},
+     2,
+     ld_one_add},
+    {"ld-one-sub",
+     {opcodes({Opcode::LD}), opcodes({Opcode::SUB})},
+     2,
+     ld_one_sub},
+    {"inc-dec", {INC_DEC, INC_DEC}, 2, inc_dec},
+    {"branch-over-br",
+     {CONDITIONAL_BRANCHES, opcodes({Opcode::BR}), LABEL},
+     3,
+     branch_over_br},
+    {"branch-to-next", {BRANCHES, LABEL}, 2, branch_to_next},
+};
+
+bool matches(PeepholeRule const &rule,
+             std::span<fnt::DenseInstr const> window) {
+  for (std::size_t i = 0; i < rule.length; ++i) {
+    auto bit = OpcodeMask{1} << static_cast<int>(window[i].opcode);
+    if ((rule.pattern[i] & bit) == 0)
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::span<PeepholeRule const> default_rules() { return DEFAULT_RULES; }
+
+fnt::DenseProgram run_peephole(fnt::DenseProgram const &program,
+                               std::span<PeepholeRule const> rules,
+                               PeepholeStats &stats) {
+  stats = PeepholeStats{};
+  stats.instructions_before = program.size();
+  for (auto const &rule : rules) {
+    if (rule.length == 0 or rule.length > MAX_WINDOW)
+      throw std::runtime_error("Invalid peephole rule: " +
+                               std::string{rule.name});
+    stats.fired.push_back({rule.name, 0});
+  }
+
+  // Instructions still to be seen are kept reversed on a stack, so that a
+  // replacement and the instructions before it can be pushed back and seen
+  // again. The window is always the end of the output.
+  auto input = fnt::DenseProgram::code_type{program.begin(), program.end()};
+  std::reverse(input.begin(), input.end());
+  auto code = fnt::DenseProgram::code_type{};
+  code.reserve(program.size());
+
+  while (not input.empty()) {
+    code.push_back(input.back());
+    input.pop_back();
+
+    for (std::size_t r = 0; r < rules.size(); ++r) {
+      auto const &rule = rules[r];
+      if (code.size() < rule.length)
+        continue;
+
+      auto window = std::span{code}.last(rule.length);
+      auto replacement = Replacement{};
+      if (not matches(rule, window) or not rule.rewrite(window, replacement))
+        continue;
+
+      ++stats.fired[r].count;
+      code.resize(code.size() - rule.length);
+      for (auto i = replacement.size; i-- > 0;)
+        input.push_back(replacement.code[i]);
+
+      auto back = std::min(code.size(), MAX_WINDOW - 1);
+      for (std::size_t i = 0; i < back; ++i) {
+        input.push_back(code.back());
+        code.pop_back();
+      }
+      break;
+    }
+  }
+
+  stats.instructions_after = code.size();
+
+  return replace_code(program, std::move(code));
+}
+
+fnt::DenseProgram run_peephole(fnt::DenseProgram const &program) {
+  auto stats = PeepholeStats{};
+  return run_peephole(program, default_rules(), stats);
+}
+
+} // namespace opt
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace vm {
+
+namespace {
+
+/*
+ * Arithmetic wraps around on overflow, as the native backends do.
+ */
+
+std::int32_t wrap_add(std::int32_t lhs, std::int32_t rhs) {
+  return static_cast<std::int32_t>(static_cast<std::uint32_t>(lhs) +
+                                   static_cast<std::uint32_t>(rhs));
+}
+
+std::int32_t wrap_sub(std::int32_t lhs, std::int32_t rhs) {
+  return static_cast<std::int32_t>(static_cast<std::uint32_t>(lhs) -
+                                   static_cast<std::uint32_t>(rhs));
+}
+
+std::int32_t wrap_mul(std::int32_t lhs, std::int32_t rhs) {
+  return static_cast<std::int32_t>(static_cast<std::uint32_t>(lhs) *
+                                   static_cast<std::uint32_t>(rhs));
+}
+
+bool divide(std::int32_t lhs, std::int32_t rhs, std::int32_t &res) {
+  if (rhs == 0)
+    return false;
+
+  if (lhs == std::numeric_limits<std::int32_t>::min() and rhs == -1)
+    res = lhs;
+  else
+    res = lhs / rhs;
+
+  return true;
+}
+
+/**
+ * Local copy of the machine state, so that registers can live in host
+ * registers while the program runs.
+ */
+struct Frame {
+  std::int32_t r[REGISTER_COUNT];
+  std::int32_t *memory;
+  std::uint64_t steps = 0;
+
+  explicit Frame(State &state) : memory(state.memory.data()) {
+    std::memcpy(r, state.registers.data(), sizeof(r));
+  }
+
+  void save(State &state) const {
+    std::memcpy(state.registers.data(), r, sizeof(r));
+    state.steps += steps;
+  }
+};
+
+[[noreturn]] void division_by_zero(Frame const &frame, State &state) {
+  frame.save(state);
+  throw std::runtime_error("Division by zero.");
+}
+
+/**
+ * Direct-threaded interpreter. Called without code, it gives the addresses of
+ * its handlers.
+ */
+void const *const *execute(Code const *code, State *state) {
+  static void const *const handlers[] = {
+      &&op_br,  &&op_ld,  &&op_str, &&op_out, &&op_add,  &&op_sub,
+      &&op_mul, &&op_div, &&op_inc, &&op_dec, &&op_be,   &&op_bn,
+      &&op_bg,  &&op_bs,  &&op_bge, &&op_bse, &&op_halt,
+      // Superinstructions, in the order of Fused.
+      &&op_add_inc_bn, &&op_inc_bn, &&op_dec_bn, &&op_inc_bs,
+      &&op_sub_bg, &&op_ld_add, &&op_add_inc, &&op_mul_add,
+  };
+  static_assert(sizeof(handlers) / sizeof(handlers[0]) ==
+                static_cast<std::size_t>(Op::_COUNT) +
+                    static_cast<std::size_t>(Fused::_COUNT));
+
+  if (code == nullptr)
+    return handlers;
+
+  auto frame = Frame{*state};
+  auto &r = frame.r;
+  auto ip = code;
+
+#define DISPATCH() goto *const_cast<void *>(ip->handler)
+#define NEXT()                                                                 \
+  do {                                                                         \
+    ++frame.steps;                                                             \
+    ++ip;                                                                      \
+    DISPATCH();                                                                \
+  } while (0)
+#define BRANCH_IF(cond)                                                        \
+  do {                                                                         \
+    ++frame.steps;                                                             \
+    ip = (cond) ? code + ip->target : ip + 1;                                  \
+    DISPATCH();                                                                \
+  } while (0)
+#define FUSED_NEXT(n)                                                          \
+  do {                                                                         \
+    frame.steps += n;                                                          \
+    ip += n;                                                                   \
+    DISPATCH();                                                                \
+  } while (0)
+#define FUSED_BRANCH_IF(n, cond)                                               \
+  do {                                                                         \
+    frame.steps += n;                                                          \
+    ip = (cond) ? code + ip[n - 1].target : ip + n;                            \
+    DISPATCH();                                                                \
+  } while (0)
+
+  DISPATCH();
+
+op_br:
+  BRANCH_IF(true);
+op_ld:
+  r[ip->a] = ip->imm;
+  NEXT();
+op_str:
+  frame.memory[ip->imm] = r[ip->a];
+  NEXT();
+op_out:
+  detail::output(state->output, r[ip->a]);
+  NEXT();
+op_add:
+  r[ip->a] = wrap_add(r[ip->b], r[ip->c]);
+  NEXT();
+op_sub:
+  r[ip->a] = wrap_sub(r[ip->b], r[ip->c]);
+  NEXT();
+op_mul:
+  r[ip->a] = wrap_mul(r[ip->b], r[ip->c]);
+  NEXT();
+op_div:
+  if (not divide(r[ip->b], r[ip->c], r[ip->a]))
+    division_by_zero(frame, *state);
+  NEXT();
+op_inc:
+  r[ip->a] = wrap_add(r[ip->a], 1);
+  NEXT();
+op_dec:
+  r[ip->a] = wrap_sub(r[ip->a], 1);
+  NEXT();
+op_be:
+  BRANCH_IF(r[ip->a] == r[ip->b]);
+op_bn:
+  BRANCH_IF(r[ip->a] != r[ip->b]);
+op_bg:
+  BRANCH_IF(r[ip->a] > r[ip->b]);
+op_bs:
+  BRANCH_IF(r[ip->a] < r[ip->b]);
+op_bge:
+  BRANCH_IF(r[ip->a] >= r[ip->b]);
+op_bse:
+  BRANCH_IF(r[ip->a] <= r[ip->b]);
+op_halt:
+  frame.save(*state);
+  return nullptr;
+
+op_add_inc_bn:
+  r[ip->a] = wrap_add(r[ip->b], r[ip->c]);
+  r[ip[1].a] = wrap_add(r[ip[1].a], 1);
+  FUSED_BRANCH_IF(3, r[ip[2].a] != r[ip[2].b]);
+op_inc_bn:
+  r[ip->a] = wrap_add(r[ip->a], 1);
+  FUSED_BRANCH_IF(2, r[ip[1].a] != r[ip[1].b]);
+op_dec_bn:
+  r[ip->a] = wrap_sub(r[ip->a], 1);
+  FUSED_BRANCH_IF(2, r[ip[1].a] != r[ip[1].b]);
+op_inc_bs:
+  r[ip->a] = wrap_add(r[ip->a], 1);
+  FUSED_BRANCH_IF(2, r[ip[1].a] < r[ip[1].b]);
+op_sub_bg:
+  r[ip->a] = wrap_sub(r[ip->b], r[ip->c]);
+  FUSED_BRANCH_IF(2, r[ip[1].a] > r[ip[1].b]);
+op_ld_add:
+  r[ip->a] = ip->imm;
+  r[ip[1].a] = wrap_add(r[ip[1].b], r[ip[1].c]);
+  FUSED_NEXT(2);
+op_add_inc:
+  r[ip->a] = wrap_add(r[ip->b], r[ip->c]);
+  r[ip[1].a] = wrap_add(r[ip[1].a], 1);
+  FUSED_NEXT(2);
+op_mul_add:
+  r[ip->a] = wrap_mul(r[ip->b], r[ip->c]);
+  r[ip[1].a] = wrap_add(r[ip[1].b], r[ip[1].c]);
+  FUSED_NEXT(2);
+
+#undef FUSED_BRANCH_IF
+#undef FUSED_NEXT
+#undef BRANCH_IF
+#undef NEXT
+#undef DISPATCH
+}
+
+} // namespace
+
+namespace detail {
+
+void output(std::string &buffer, std::int32_t value) {
+  char digits[16];
+  auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+
+  buffer.append(digits, end);
+  buffer.push_back('\n');
+}
+
+void const *const *threaded_handlers() { return execute(nullptr, nullptr); }
+
+} // namespace detail
+
+void run_threaded(Executable const &executable, State &state) {
+  if (state.memory.size() < executable.memory_size())
+    state.memory.resize(executable.memory_size(), 0);
+
+  execute(executable.get_code().data(), &state);
+}
+
+namespace {
+
+/**
+ * Switch loop, calling a hook with the index of each instruction before it
+ * runs.
+ */
+template <typename Hook>
+void switch_loop(Executable const &executable, State &state, Hook hook) {
+  if (state.memory.size() < executable.memory_size())
+    state.memory.resize(executable.memory_size(), 0);
+
+  auto const *code = executable.get_code().data();
+  auto frame = Frame{state};
+  auto &r = frame.r;
+  std::size_t pc = 0;
+
+  for (;;) {
+    auto const &c = code[pc];
+    bool taken = false;
+    hook(pc);
+
+    switch (c.op) {
+    case Op::BR:
+      taken = true;
+      break;
+    case Op::LD:
+      r[c.a] = c.imm;
+      break;
+    case Op::STR:
+      frame.memory[c.imm] = r[c.a];
+      break;
+    case Op::OUT:
+      detail::output(state.output, r[c.a]);
+      break;
+    case Op::ADD:
+      r[c.a] = wrap_add(r[c.b], r[c.c]);
+      break;
+    case Op::SUB:
+      r[c.a] = wrap_sub(r[c.b], r[c.c]);
+      break;
+    case Op::MUL:
+      r[c.a] = wrap_mul(r[c.b], r[c.c]);
+      break;
+    case Op::DIV:
+      if (not divide(r[c.b], r[c.c], r[c.a]))
+        division_by_zero(frame, state);
+      break;
+    case Op::INC:
+      r[c.a] = wrap_add(r[c.a], 1);
+      break;
+    case Op::DEC:
+      r[c.a] = wrap_sub(r[c.a], 1);
+      break;
+    case Op::BE:
+      taken = r[c.a] == r[c.b];
+      break;
+    case Op::BN:
+      taken = r[c.a] != r[c.b];
+      break;
+    case Op::BG:
+      taken = r[c.a] > r[c.b];
+      break;
+    case Op::BS:
+      taken = r[c.a] < r[c.b];
+      break;
+    case Op::BGE:
+      taken = r[c.a] >= r[c.b];
+      break;
+    case Op::BSE:
+      taken = r[c.a] <= r[c.b];
+      break;
+    default:
+      frame.save(state);
+      return;
+    }
+
+    ++frame.steps;
+    pc = taken ? c.target : pc + 1;
+  }
+}
+
+} // namespace
+
+void run_switch(Executable const &executable, State &state) {
+  switch_loop(executable, state, [](std::size_t) {});
+}
+
+namespace detail {
+
+void run_counting(Executable const &executable, State &state,
+                  std::vector<std::uint64_t> &hits) {
+  hits.assign(executable.get_code().size(), 0);
+  switch_loop(executable, state, [&](std::size_t pc) { ++hits[pc]; });
+}
+
+} // namespace detail
+
+} // namespace vm
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <vm/profile.hpp>
+
+namespace cmp {
+
+namespace vm {
+
+namespace {
+
+bool is_branch(Op op) { return fnt::is_branch(static_cast<fnt::Opcode>(op)); }
+
+std::uint32_t pack(std::array<Op, MAX_FUSED_LENGTH> const &ops,
+                   std::size_t length) {
+  auto res = static_cast<std::uint32_t>(length) << 24;
+  for (std::size_t k = 0; k < length; ++k)
+    res |= static_cast<std::uint32_t>(ops[k]) << (16 - 8 * k);
+  return res;
+}
+
+/**
+ * Adds a count to the entry of a sequence, keeping entries unique.
+ */
+void add_sequence(std::vector<SequenceCount> &sequences,
+                  std::array<Op, MAX_FUSED_LENGTH> const &ops,
+                  std::size_t length, std::uint64_t count) {
+  auto it = std::find_if(sequences.begin(), sequences.end(), [&](auto &s) {
+    return s.length == length and s.ops == ops;
+  });
+
+  if (it != sequences.end())
+    it->count += count;
+  else
+    sequences.push_back({ops, length, count});
+}
+
+} // namespace
+
+std::vector<SequenceCount> Profile::hottest(std::size_t count) const {
+  auto res = sequences;
+  std::stable_sort(res.begin(), res.end(), [](auto &lhs, auto &rhs) {
+    return lhs.count > rhs.count;
+  });
+
+  if (res.size() > count)
+    res.resize(count);
+
+  return res;
+}
+
+void run_profiled(Executable const &executable, State &state,
+                  Profile &profile) {
+  auto hits = std::vector<std::uint64_t>{};
+  detail::run_counting(executable, state, hits);
+
+  auto const &code = executable.get_code();
+  auto targets = detail::branch_targets(code);
+
+  // Sequences are first counted in a table keyed by their packed operations.
+  auto counts = std::unordered_map<std::uint32_t, std::uint64_t>{};
+  for (std::size_t i = 0; i < code.size(); ++i) {
+    if (hits[i] == 0)
+      continue;
+
+    auto ops = std::array<Op, MAX_FUSED_LENGTH>{};
+    for (std::size_t length = 1; length <= MAX_FUSED_LENGTH; ++length) {
+      auto last = i + length - 1;
+      if (last >= code.size() or code[last].op == Op::HALT or
+          (length > 1 and targets[last]))
+        break;
+
+      ops[length - 1] = code[last].op;
+      if (length > 1)
+        counts[pack(ops, length)] += hits[i];
+      if (is_branch(code[last].op))
+        break;
+    }
+
+    for (auto const &pattern : FUSED_PATTERNS) {
+      if (detail::matches(code, targets, i, pattern))
+        profile.fused[static_cast<std::size_t>(pattern.id)] += hits[i];
+    }
+  }
+
+  for (auto [key, count] : counts) {
+    auto length = key >> 24;
+    auto ops = std::array<Op, MAX_FUSED_LENGTH>{};
+    for (std::size_t k = 0; k < length; ++k)
+      ops[k] = static_cast<Op>((key >> (16 - 8 * k)) & 0xff);
+    add_sequence(profile.sequences, ops, length, count);
+  }
+}
+
+FusionSet select_fusions(Profile const &profile, std::size_t limit) {
+  auto order = std::vector<std::size_t>(FUSED_PATTERNS.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  // Weighs each superinstruction by the instructions it covers.
+  auto weight = [&](std::size_t i) {
+    return profile.fused[i] * FUSED_PATTERNS[i].length;
+  };
+  std::stable_sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+    return weight(lhs) > weight(rhs);
+  });
+
+  auto res = NO_FUSIONS;
+  for (std::size_t i = 0; i < order.size() and i < limit; ++i) {
+    if (profile.fused[order[i]] > 0)
+      res |= fusion_bit(FUSED_PATTERNS[order[i]].id);
+  }
+
+  return res;
+}
+
+} // namespace vm
+
+} // namespace cmp
\ No newline at end of file
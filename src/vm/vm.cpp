@@ -0,0 +1,150 @@
+#include <stdexcept>
+#include <string>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace vm {
+
+static_assert(static_cast<int>(Op::BSE) == static_cast<int>(fnt::Opcode::BSE),
+              "operations must follow the dense opcodes");
+
+State::State(std::size_t memory_size) : memory(memory_size, 0) {}
+
+namespace {
+
+/**
+ * Gives the first instruction of each superinstruction its fused handler.
+ */
+void fuse(std::vector<Code> &code, FusionSet fusions) {
+  if (fusions == NO_FUSIONS)
+    return;
+
+  auto handlers = detail::threaded_handlers();
+  auto targets = detail::branch_targets(code);
+
+  for (std::size_t i = 0; i < code.size();) {
+    std::size_t length = 1;
+
+    for (auto const &pattern : FUSED_PATTERNS) {
+      if ((fusions & fusion_bit(pattern.id)) == 0 or
+          not detail::matches(code, targets, i, pattern))
+        continue;
+
+      auto index = static_cast<std::size_t>(Op::_COUNT) +
+                   static_cast<std::size_t>(pattern.id);
+      code[i].handler = handlers[index];
+      length = pattern.length;
+      break;
+    }
+
+    i += length;
+  }
+}
+
+} // namespace
+
+FusionSet default_fusions() {
+#ifdef CMP_SUPERINSTRUCTIONS
+  return static_cast<FusionSet>(CMP_SUPERINSTRUCTIONS) & ALL_FUSIONS;
+#else
+  return NO_FUSIONS;
+#endif
+}
+
+Executable Executable::lower(fnt::DenseProgram const &program,
+                             std::size_t memory_size, FusionSet fusions) {
+  auto res = Executable{};
+  auto const &symbols = program.get_symbols();
+
+  // Index of each dense instruction once labels are removed. A label thus
+  // stands for the instruction following it.
+  auto indices = std::vector<std::uint32_t>(program.size() + 1);
+  std::uint32_t index = 0;
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    indices[i] = index;
+    index += program[i].opcode != fnt::Opcode::LABEL;
+  }
+  indices[program.size()] = index;
+
+  auto handlers = detail::threaded_handlers();
+
+  res._memory_size = memory_size;
+  res._code.reserve(index + 1);
+
+  for (auto const &instr : program) {
+    if (instr.opcode == fnt::Opcode::LABEL)
+      continue;
+
+    auto op = static_cast<Op>(instr.opcode);
+    auto code = Code{handlers[static_cast<int>(op)], op, instr.a, instr.b,
+                     instr.c, instr.imm, 0};
+
+    if (fnt::is_branch(instr.opcode)) {
+      auto target = symbols.target(instr.label());
+      if (target == fnt::SymbolTable::NO_TARGET)
+        throw std::runtime_error("Undefined label: " +
+                                 std::string{symbols.name(instr.label())});
+      code.target = indices[target];
+    }
+
+    if (instr.opcode == fnt::Opcode::STR and
+        (instr.imm < 0 or static_cast<std::size_t>(instr.imm) >= memory_size))
+      throw std::runtime_error("Memory cell out of range: " +
+                               std::to_string(instr.imm));
+
+    res._code.push_back(code);
+  }
+
+  res._code.push_back(
+      {handlers[static_cast<int>(Op::HALT)], Op::HALT, 0, 0, 0, 0, 0});
+  fuse(res._code, fusions);
+
+  return res;
+}
+
+std::vector<Code> const &Executable::get_code() const { return _code; }
+
+std::size_t Executable::memory_size() const { return _memory_size; }
+
+namespace detail {
+
+std::vector<bool> branch_targets(std::vector<Code> const &code) {
+  auto res = std::vector<bool>(code.size(), false);
+
+  for (auto const &c : code) {
+    if (fnt::is_branch(static_cast<fnt::Opcode>(c.op)))
+      res[c.target] = true;
+  }
+
+  return res;
+}
+
+bool matches(std::vector<Code> const &code, std::vector<bool> const &targets,
+             std::size_t index, FusedPattern const &pattern) {
+  if (index + pattern.length > code.size())
+    return false;
+
+  for (std::size_t i = 0; i < pattern.length; ++i) {
+    if (code[index + i].op != pattern.ops[i] or (i > 0 and targets[index + i]))
+      return false;
+  }
+
+  return true;
+}
+
+} // namespace detail
+
+State run(fnt::DenseProgram const &program, std::ostream &out) {
+  auto executable = Executable::lower(program);
+  auto res = State{executable.memory_size()};
+
+  run_threaded(executable, res);
+  out << res.output;
+
+  return res;
+}
+
+} // namespace vm
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "tests.hpp"
+#include <back/assembly.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "assembly";
+
+// Assembling and linking takes far longer than a run in the VM, so fewer
+// programs are checked.
+constexpr std::size_t CASES_PER_PROGRAM = 100;
+
+constexpr std::int32_t EDGE_VALUES[] = {
+    std::numeric_limits<std::int32_t>::min(),
+    -1,
+    0,
+    1,
+    std::numeric_limits<std::int32_t>::max(),
+};
+
+constexpr std::string_view CONDITIONS[] = {"be", "bn", "bg",
+                                           "bs", "bge", "bse"};
+
+bool has_toolchain() {
+  return std::system("cc --version > /dev/null 2>&1") == 0;
+}
+
+/**
+ * Assembles, links and runs a program. The program fails when it exits with
+ * a non-zero status, as on a division by zero.
+ */
+Outcome run_native(fnt::DenseProgram const &program,
+                   std::filesystem::path const &dir) {
+  auto source = dir / "program.s";
+  auto binary = dir / "program";
+
+  {
+    auto out = std::ofstream{source, std::ios::trunc};
+    out << bck::emit_assembly(program);
+  }
+
+  auto command = "cc " + source.string() + " -o " + binary.string();
+  if (std::system(command.c_str()) != 0)
+    throw std::runtime_error("The emitted assembly does not build.");
+
+  auto pipe = ::popen((binary.string() + " 2> /dev/null").c_str(), "r");
+  if (pipe == nullptr)
+    throw std::runtime_error("The program cannot be run.");
+
+  auto res = Outcome{};
+  char buffer[4096];
+  for (std::size_t n; (n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0;)
+    res.output.append(buffer, n);
+
+  auto status = ::pclose(pipe);
+  res.failed = not WIFEXITED(status) or WEXITSTATUS(status) != 0;
+
+  return res;
+}
+
+std::size_t check(std::string const &text, std::filesystem::path const &dir) {
+  auto program = compile_text(text);
+  auto expected = run_program(program);
+  auto actual = run_native(program, dir);
+
+  if (actual != expected) {
+    report(NAME,
+           "outcomes differ: " + actual.output + " instead of " +
+               expected.output,
+           text);
+    return 1;
+  }
+
+  return 0;
+}
+
+// Literals are never negative, so some values are computed.
+std::string load(std::string_view reg, std::int32_t value) {
+  auto r = std::string{reg};
+
+  if (value == std::numeric_limits<std::int32_t>::min())
+    return "  ld " + r + " 2147483647\n  inc " + r + "\n";
+
+  if (value < 0)
+    return "  ld " + r + " " + std::to_string(-value) + "\n  sub " + r +
+           " r0 " + r + "\n";
+
+  return "  ld " + r + " " + std::to_string(value) + "\n";
+}
+
+/**
+ * Checks every branch condition, then a division, by zero and of the smallest
+ * integer by -1 included, on every pair of edge values. Each pair is a single
+ * program, to save builds.
+ */
+std::size_t check_edges(std::filesystem::path const &dir) {
+  std::size_t res = 0;
+
+  for (auto lhs : EDGE_VALUES) {
+    for (auto rhs : EDGE_VALUES) {
+      auto text = load("r1", lhs) + load("r2", rhs);
+
+      for (std::size_t i = 0; i < std::size(CONDITIONS); ++i) {
+        auto taken = "t" + std::to_string(i);
+        auto next = "n" + std::to_string(i);
+        text += "  " + std::string{CONDITIONS[i]} + " " + taken +
+                " r1 r2\n  ld r3 1\n  br " + next + "\n" + taken +
+                "\n  ld r3 2\n" + next + "\n  out r3\n";
+      }
+
+      res += check(text + "  div r3 r1 r2\n  out r3\n", dir);
+    }
+  }
+
+  return res;
+}
+
+} // namespace
+
+std::size_t test_assembly(std::size_t count) {
+  if (not has_toolchain())
+    return 0;
+
+  auto dir = std::filesystem::temp_directory_path() /
+             ("cmp-tests-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(dir);
+
+  std::size_t res = check_edges(dir);
+
+  for (std::size_t seed = 0; seed * CASES_PER_PROGRAM < count; ++seed)
+    res += check(random_program(seed), dir);
+
+  std::filesystem::remove_all(dir);
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
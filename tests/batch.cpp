@@ -0,0 +1,177 @@
+#include "tests.hpp"
+#include <back/object.hpp>
+#include <driver/batch.hpp>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <front/repr.hpp>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "batch";
+
+// Writing files takes far longer than compiling, so fewer programs are
+// checked.
+constexpr std::size_t CASES_PER_PROGRAM = 100;
+
+// Sources of the batch, under nested directories. Only .asm files are
+// collected, and bad.asm cannot be compiled.
+constexpr std::string_view SOURCES[] = {
+    "a.asm", "bad.asm", "sub/b.asm", "sub/deep/c.asm", "sub/notes.txt",
+};
+
+void write_file(std::filesystem::path const &path, std::string const &text) {
+  std::filesystem::create_directories(path.parent_path());
+  auto out = std::ofstream{path, std::ios::trunc};
+  out << text;
+}
+
+std::string source_text(std::string_view name, std::size_t seed) {
+  return name == "bad.asm" ? "  add r1 r2\n" : random_program(seed);
+}
+
+/**
+ * Checks that a program written as an object maps back, verified or not, into
+ * the same program, from a dense program as from its representation.
+ */
+std::size_t check_round_trip(std::string const &text,
+                             std::filesystem::path const &dir) {
+  auto path = (dir / "program.o").string();
+  auto program = compile_text(text);
+  auto stream = std::istringstream{text};
+  auto repr = fnt::ProgramRepr::from_stream(stream);
+
+  bck::write_object(program, path);
+  for (bool verify : {true, false}) {
+    if (not same_program(bck::ObjectFile::map(path, verify).to_dense_program(),
+                         program)) {
+      report(NAME, "an object does not map back into its program", text);
+      return 1;
+    }
+  }
+
+  bck::write_object(repr, path);
+  if (not same_program(bck::ObjectFile::map(path).to_dense_program(),
+                       program)) {
+    report(NAME, "the object of a representation differs", text);
+    return 1;
+  }
+
+  return 0;
+}
+
+std::size_t fail(std::string const &message) {
+  report(NAME, message);
+  return 1;
+}
+
+/**
+ * Compiles a directory of sources, checks that the objects mirror it and map
+ * back into the programs, and that the results do not depend on the number of
+ * threads.
+ */
+std::size_t check_batch(std::filesystem::path const &dir) {
+  auto src = dir / "src";
+  for (std::size_t i = 0; i < std::size(SOURCES); ++i)
+    write_file(src / SOURCES[i], source_text(SOURCES[i], i));
+
+  auto sources = drv::collect_sources({src.string()});
+  if (sources.size() != 4)
+    return fail("collected " + std::to_string(sources.size()) + " sources");
+
+  for (std::size_t i = 0; i < sources.size(); ++i) {
+    auto expected = SOURCES[i];
+    if (sources[i].path != (src / expected).string() or
+        sources[i].relative_path != expected)
+      return fail("collected " + sources[i].path + " as " +
+                  sources[i].relative_path);
+  }
+
+  auto single = drv::collect_sources({(src / "sub/b.asm").string()});
+  if (single.size() != 1 or single[0].relative_path != "b.asm")
+    return fail("a file given alone is not named after itself");
+
+  auto previous = std::vector<drv::CompileResult>{};
+  for (std::size_t threads : {1, 4}) {
+    auto out = dir / ("out" + std::to_string(threads));
+    auto results = drv::compile_batch(
+        sources, drv::BatchOptions{threads, out.string(), nullptr, false});
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      auto const &result = results[i];
+      auto name = std::string{SOURCES[i]};
+      auto object = (out / name).replace_extension(".o").string();
+
+      if (result.path != sources[i].path or result.object_path != object)
+        return fail(name + " is compiled into " + result.object_path);
+
+      if (name == "bad.asm") {
+        if (result.ok or result.diagnostic.rfind(result.path + ": ", 0) != 0)
+          return fail("bad.asm is reported as: " + result.diagnostic);
+        continue;
+      }
+
+      auto program = compile_text(source_text(name, i));
+      if (not result.ok or result.instruction_count != program.size() or
+          not same_program(bck::ObjectFile::map(object).to_dense_program(),
+                           program))
+        return fail("the object of " + name + " differs");
+    }
+
+    for (std::size_t i = 0; i < previous.size(); ++i)
+      if (previous[i].ok != results[i].ok or
+          previous[i].diagnostic != results[i].diagnostic)
+        return fail("results depend on the number of threads");
+    previous = std::move(results);
+  }
+
+  auto lint_out = dir / "lint";
+  auto linted = drv::compile_batch(
+      sources, drv::BatchOptions{2, lint_out.string(), nullptr, true});
+  if (std::filesystem::exists(lint_out) or not linted[0].object_path.empty() or
+      linted[1].ok)
+    return fail("linting writes objects or accepts bad.asm");
+
+  // Both would be compiled into out/a.o.
+  write_file(dir / "other/a.asm", source_text("a.asm", 0));
+  try {
+    drv::compile_batch(
+        drv::collect_sources({(src / "a.asm").string(),
+                              (dir / "other/a.asm").string()}),
+        drv::BatchOptions{1, (dir / "out").string(), nullptr, false});
+    return fail("two sources are compiled into the same object");
+  } catch (std::exception const &) {
+  }
+
+  return 0;
+}
+
+} // namespace
+
+std::size_t test_batch(std::size_t count) {
+  auto dir = std::filesystem::temp_directory_path() /
+             ("cmp-tests-batch-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(dir);
+
+  std::size_t res = check_batch(dir);
+
+  for (std::size_t seed = 0; seed * CASES_PER_PROGRAM < count; ++seed)
+    res += check_round_trip(random_program(seed), dir);
+
+  std::filesystem::remove_all(dir);
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
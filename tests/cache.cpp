@@ -0,0 +1,177 @@
+#include "tests.hpp"
+#include <algorithm>
+#include <back/object.hpp>
+#include <driver/batch.hpp>
+#include <driver/cache.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "cache";
+
+// Writing files takes far longer than compiling, so fewer programs are
+// checked.
+constexpr std::size_t CASES_PER_SOURCE = 1000;
+
+std::size_t fail(std::string const &message) {
+  report(NAME, message);
+  return 1;
+}
+
+void write_file(std::filesystem::path const &path, std::string const &text) {
+  std::filesystem::create_directories(path.parent_path());
+  auto out = std::ofstream{path, std::ios::trunc};
+  out << text;
+}
+
+// Flips a byte in the middle of every entry of the cache.
+void corrupt_entries(std::filesystem::path const &dir) {
+  for (auto const &entry : std::filesystem::recursive_directory_iterator{dir}) {
+    if (not entry.is_regular_file())
+      continue;
+
+    auto file = std::fstream{entry.path(), std::ios::in | std::ios::out |
+                                               std::ios::binary};
+    file.seekg(static_cast<std::streamoff>(entry.file_size() / 2));
+    auto byte = static_cast<char>(file.get() ^ 0x5a);
+    file.seekp(static_cast<std::streamoff>(entry.file_size() / 2));
+    file.put(byte);
+  }
+}
+
+/**
+ * Sources of the batch, the last of which cannot be compiled, and compiles
+ * them through a cache, checking every object against the program.
+ */
+struct Batch {
+  std::filesystem::path dir;
+  std::vector<std::string> texts;
+  std::vector<drv::SourceFile> sources;
+
+  Batch(std::filesystem::path dir, std::size_t count) : dir(std::move(dir)) {
+    for (std::size_t i = 0; i < count; ++i)
+      texts.push_back(random_program(i));
+    texts.push_back("  add r1 r2\n");
+
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+      auto name = std::to_string(i) + ".asm";
+      write_file(this->dir / "src" / name, texts[i]);
+      sources.push_back({(this->dir / "src" / name).string(), name});
+    }
+  }
+
+  void edit(std::size_t index, std::string text) {
+    texts[index] = std::move(text);
+    write_file(sources[index].path, texts[index]);
+  }
+
+  /**
+   * Compiles the batch with a cache opened anew, and gets which programs came
+   * from the cache, or an empty vector on a failure.
+   */
+  std::vector<bool> compile(drv::CacheStats &stats,
+                            std::uintmax_t max_size = drv::DEFAULT_CACHE_SIZE) {
+    auto cache = drv::CompileCache{(dir / "cache").string(), max_size};
+    auto out = dir / "out";
+    auto results = drv::compile_batch(
+        sources, drv::BatchOptions{2, out.string(), &cache, false});
+    stats = cache.stats();
+
+    auto res = std::vector<bool>{};
+    for (std::size_t i = 0; i + 1 < results.size(); ++i) {
+      auto program = compile_text(texts[i]);
+      if (not results[i].ok or
+          not same_program(
+              bck::ObjectFile::map(results[i].object_path).to_dense_program(),
+              program)) {
+        fail("the object of " + sources[i].path + " differs");
+        return {};
+      }
+      res.push_back(results[i].cached);
+    }
+
+    if (results.back().ok or results.back().cached) {
+      fail("an invalid source is compiled");
+      return {};
+    }
+
+    return res;
+  }
+};
+
+std::size_t check_keys(std::string const &text) {
+  auto key = drv::CacheKey::from_source(text);
+  auto same = drv::CacheKey::from_source(std::string{text});
+  auto edited = drv::CacheKey::from_source(text + " ");
+  auto options = drv::CacheKey::from_source(text, 1);
+
+  if (key.to_string() != same.to_string())
+    return fail("a source has several keys");
+
+  if (key.to_string() == edited.to_string() or
+      key.to_string() == options.to_string())
+    return fail("an edit or other options keep the key");
+
+  return 0;
+}
+
+} // namespace
+
+std::size_t test_cache(std::size_t count) {
+  auto dir = std::filesystem::temp_directory_path() /
+             ("cmp-tests-cache-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(dir);
+
+  auto source_count = std::max<std::size_t>(2, count / CASES_PER_SOURCE);
+  auto batch = Batch{dir, source_count};
+  auto stats = drv::CacheStats{};
+  auto none = std::vector<bool>(source_count, false);
+  auto all = std::vector<bool>(source_count, true);
+  auto res = check_keys(batch.texts[0]);
+
+  // The invalid source is missed every time, and never stored.
+  if (batch.compile(stats) != none or stats.stores != source_count or
+      stats.misses != source_count + 1)
+    res += fail("an empty cache is not filled");
+
+  if (batch.compile(stats) != all or stats.hits != source_count)
+    res += fail("a second build does not hit the cache");
+
+  auto original = batch.texts[1];
+  batch.edit(1, original + "  out r1\n");
+  auto expected = all;
+  expected[1] = false;
+  if (batch.compile(stats) != expected or stats.stores != 1)
+    res += fail("an edited source is not compiled again");
+
+  batch.edit(1, original);
+  if (batch.compile(stats) != all)
+    res += fail("the entry of a source edited back is lost");
+
+  corrupt_entries(dir / "cache");
+  if (batch.compile(stats) != none or batch.compile(stats) != all)
+    res += fail("corrupted entries are not replaced");
+
+  if (batch.compile(stats, 1) != all or stats.evictions != source_count + 1)
+    res += fail("entries are not evicted once over the maximum size");
+
+  if (batch.compile(stats) != none)
+    res += fail("evicted entries are still hit");
+
+  std::filesystem::remove_all(dir);
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "tests.hpp"
+#include <exception>
+#include <front/diagnostic.hpp>
+#include <front/repr.hpp>
+#include <front/source.hpp>
+#include <front/token.hpp>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "diagnostics";
+
+struct ExpectedDiagnostic {
+  std::size_t line;
+  std::size_t column;
+  std::string_view message;
+};
+
+struct DiagnosticCase {
+  std::string_view name;
+  std::string_view text;
+  std::vector<ExpectedDiagnostic> diagnostics;
+};
+
+std::vector<DiagnosticCase> const &diagnostic_cases() {
+  static auto const res = std::vector<DiagnosticCase>{
+      {"missing operand",
+       "  add r1 r2\n  out r1\n",
+       {{2, 3,
+         "add <destination> <lhs> <rhs>: expected a register, found an "
+         "instruction: out"}}},
+      {"duplicate label",
+       "a\n  out r1\na\n  br a\n",
+       {{3, 1, "Label defined twice: a"}}},
+      {"undefined label",
+       "  br nowhere\n",
+       {{1, 6, "Undefined label: nowhere"}}},
+      {"integer out of range",
+       "  ld r1 2147483648\n",
+       {{1, 9, "Integer out of range: 2147483648"}}},
+      {"truncated tail",
+       "  out r1\n  add r1 r2",
+       {{2, 3, "Unexpected end of program: add <destination> <lhs> <rhs>"}}},
+      {"recovery",
+       "start\n"
+       "  ld r1 99999999999\n"
+       "  out r1\n"
+       "  str r1 r2\n"
+       "  add r1 r2 r3\n"
+       "start\n"
+       "  out 5 r3\n"
+       "  br missing\n"
+       "  inc r12\n",
+       {{2, 9, "Integer out of range: 99999999999"},
+        {4, 10,
+         "str <register> <memory>: expected an integer, found a register: r2"},
+        {6, 1, "Label defined twice: start"},
+        {7, 7, "out <register>: expected a register, found an integer: 5"},
+        {8, 6, "Undefined label: missing"},
+        {9, 7, "inc <register>: expected a register, found a label: r12"}}},
+  };
+
+  return res;
+}
+
+fnt::TextSource text_source(std::string_view text) {
+  auto stream = std::istringstream{std::string{text}};
+
+  return fnt::TextSource::from_stream(stream);
+}
+
+/**
+ * Compiles a program on a throwing path, directly into dense instructions or
+ * through the program representation. Branches to undefined labels are only
+ * rejected once lowered for the VM, so they are checked here too.
+ */
+std::optional<fnt::DenseProgram> compile_throwing(fnt::TokenTable const &table,
+                                                  bool direct = true) {
+  try {
+    auto res = direct ? fnt::DenseProgram::from_token_table(table)
+                      : fnt::DenseProgram::from_program_repr(
+                            fnt::ProgramRepr::from_token_table(table));
+
+    for (auto const &instr : res) {
+      if (fnt::is_branch(instr.opcode) and
+          res.get_symbols().target(instr.label()) ==
+              fnt::SymbolTable::NO_TARGET)
+        return std::nullopt;
+    }
+
+    return res;
+  } catch (std::exception const &) {
+    return std::nullopt;
+  }
+}
+
+template <typename F> std::string error_of(F &&build) {
+  try {
+    build();
+    return {};
+  } catch (std::exception const &e) {
+    return e.what();
+  }
+}
+
+bool same_program(fnt::DenseProgram const &lhs, fnt::DenseProgram const &rhs) {
+  if (lhs.size() != rhs.size() or lhs.label_count() != rhs.label_count())
+    return false;
+
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    if (lhs[i].opcode != rhs[i].opcode or lhs[i].a != rhs[i].a or
+        lhs[i].b != rhs[i].b or lhs[i].c != rhs[i].c or
+        lhs[i].imm != rhs[i].imm)
+      return false;
+  }
+
+  for (std::uint32_t id = 0; id < lhs.label_count(); ++id) {
+    if (lhs.label_name(id) != rhs.label_name(id) or
+        lhs.get_symbols().target(id) != rhs.get_symbols().target(id))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Damages a program as a hurried edit would: drops, inserts or replaces a
+ * word, duplicates a line, or cuts the end of the program.
+ */
+std::string mutate(std::string const &text, std::mt19937_64 &rng) {
+  static constexpr std::string_view garbage[] = {
+      "r1", "5",  "l0", "add", "x!",  "99999999999", "r",
+      "r12", "br", "-3", "end", "2147483648"};
+
+  auto lines = std::vector<std::vector<std::string>>{};
+  auto stream = std::istringstream{text};
+  for (std::string line; std::getline(stream, line);) {
+    auto words = std::istringstream{line};
+    lines.emplace_back();
+    for (std::string word; words >> word;)
+      lines.back().push_back(word);
+  }
+
+  for (auto n = rng() % 5; n > 0 and not lines.empty(); --n) {
+    auto i = rng() % lines.size();
+    auto &words = lines[i];
+    auto word = std::string{garbage[rng() % std::size(garbage)]};
+
+    switch (rng() % 5) {
+    case 0:
+      if (not words.empty())
+        words.erase(words.begin() + rng() % words.size());
+      break;
+    case 1:
+      words.insert(words.begin() + rng() % (words.size() + 1), word);
+      break;
+    case 2:
+      if (not words.empty())
+        words[rng() % words.size()] = word;
+      break;
+    case 3:
+      lines.insert(lines.begin() + i, lines[rng() % lines.size()]);
+      break;
+    default:
+      lines.resize(i);
+      break;
+    }
+  }
+
+  // Labels start their line, and instructions are indented.
+  auto res = std::string{};
+  for (auto const &words : lines) {
+    for (std::size_t k = 0; k < words.size(); ++k) {
+      if (k > 0)
+        res += ' ';
+      else if (fnt::detail::tokenize_word(words[k]) != fnt::TokenKind::LABEL)
+        res += "  ";
+      res += words[k];
+    }
+    res += '\n';
+  }
+
+  return res;
+}
+
+/**
+ * Checks the line and the column of every diagnostic against a count from
+ * the start of the text, and their order.
+ */
+bool well_located(std::string_view text,
+                  std::vector<fnt::Diagnostic> const &diagnostics) {
+  for (std::size_t i = 0; i < diagnostics.size(); ++i) {
+    auto const &diagnostic = diagnostics[i];
+    auto before = text.substr(0, diagnostic.offset);
+    // On the first line, rfind gives npos, so the line starts at 0.
+    auto line_start = before.rfind('\n') + 1;
+    std::size_t line = 1;
+    for (char c : before)
+      line += c == '\n';
+
+    if (diagnostic.message.empty() or diagnostic.line != line or
+        diagnostic.column != diagnostic.offset - line_start + 1 or
+        (i > 0 and diagnostics[i - 1].token > diagnostic.token))
+      return false;
+  }
+
+  return true;
+}
+
+std::size_t check_case(DiagnosticCase const &test) {
+  auto source = text_source(test.text);
+  auto table = fnt::TokenTable::from_text_source(source);
+  auto program = fnt::ProgramRepr::try_from_token_table(table);
+  auto name = std::string{test.name};
+
+  if (program) {
+    report(NAME, name + ": accepted", test.text);
+    return 1;
+  }
+
+  auto const &diagnostics = program.error();
+  if (diagnostics.size() != test.diagnostics.size()) {
+    report(NAME, name + ": " + std::to_string(diagnostics.size()) +
+                     " diagnostics instead of " +
+                     std::to_string(test.diagnostics.size()));
+    return 1;
+  }
+
+  std::size_t res = 0;
+  for (std::size_t i = 0; i < diagnostics.size(); ++i) {
+    auto const &expected = test.diagnostics[i];
+    auto const &diagnostic = diagnostics[i];
+
+    if (diagnostic.line != expected.line or
+        diagnostic.column != expected.column or
+        diagnostic.message != expected.message) {
+      report(NAME, name + ": got " + diagnostic.to_string("line") +
+                       ", expected line:" + std::to_string(expected.line) +
+                       ":" + std::to_string(expected.column) + ": " +
+                       std::string{expected.message});
+      ++res;
+    }
+  }
+
+  if (compile_throwing(table)) {
+    report(NAME, name + ": accepted by the throwing path", test.text);
+    ++res;
+  }
+
+  return res;
+}
+
+std::size_t check_mutant(std::string const &text) {
+  auto source = text_source(text);
+  auto table = fnt::TokenTable::from_text_source(source);
+  auto thrown = compile_throwing(table);
+  auto lowered = compile_throwing(table, false);
+  auto program = fnt::ProgramRepr::try_from_token_table(table);
+
+  auto direct_error =
+      error_of([&] { fnt::DenseProgram::from_token_table(table); });
+  auto lowered_error =
+      error_of([&] { fnt::ProgramRepr::from_token_table(table); });
+
+  if (thrown.has_value() != lowered.has_value() or
+      (thrown and not same_program(*thrown, *lowered)) or
+      direct_error != lowered_error) {
+    report(NAME, "building dense instructions directly and lowering differ",
+           text);
+    return 1;
+  }
+
+  if (program.has_value() != thrown.has_value()) {
+    report(NAME,
+           program ? "validation accepts a program the throwing path rejects"
+                   : "validation rejects a program the throwing path accepts",
+           text);
+    return 1;
+  }
+
+  if (program and
+      not same_program(fnt::DenseProgram::from_program_repr(*program),
+                       *thrown)) {
+    report(NAME, "validation and the throwing path build different programs",
+           text);
+    return 1;
+  }
+
+  if (not program and not well_located(text, program.error())) {
+    report(NAME, "diagnostics are misplaced", text);
+    return 1;
+  }
+
+  return 0;
+}
+
+} // namespace
+
+std::size_t test_diagnostics(std::size_t count) {
+  std::size_t res = 0;
+
+  for (auto const &test : diagnostic_cases())
+    res += check_case(test);
+
+  auto rng = std::mt19937_64{count};
+  for (std::size_t seed = 0; seed < count; ++seed)
+    res += check_mutant(mutate(random_program(seed), rng));
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "tests.hpp"
+#include <exception>
+#include <front/repr.hpp>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::size_t LABEL_INTERVAL = 5;
+
+// Registers of the loop counter, and of the zero it is compared to.
+constexpr char const *COUNTER = " r9";
+constexpr char const *ZERO = " r8";
+
+} // namespace
+
+std::string random_program(std::uint64_t seed, std::size_t instr_count) {
+  auto rng = std::mt19937_64{seed};
+  auto res = std::string{};
+  bool looping = seed % 2 == 1;
+  auto label_count = instr_count / LABEL_INTERVAL;
+  std::size_t next_label = 0;
+  std::size_t next_local = 0;
+
+  // The body of a loop does not write its counter nor the zero.
+  auto reg = [&] {
+    return " r" + std::to_string(rng() % (looping ? 8 : 10));
+  };
+
+  auto value = [&] {
+    return std::to_string(rng() % 2 ? rng() % 5 : rng() % 2147483648u);
+  };
+
+  // Any label still ahead, or the end of the program.
+  auto forward = [&] {
+    auto target = next_label + rng() % (label_count - next_label + 1);
+    return target >= label_count ? std::string{" end"}
+                                 : " l" + std::to_string(target);
+  };
+
+  if (looping)
+    res += "  ld" + std::string{COUNTER} + " " + std::to_string(1 + rng() % 4) +
+           "\n  ld" + ZERO + " 0\ntop\n";
+
+  for (std::size_t i = 0; i < instr_count; ++i) {
+    if (i % LABEL_INTERVAL == LABEL_INTERVAL - 1 and next_label < label_count) {
+      res += "l" + std::to_string(next_label++) + "\n";
+      continue;
+    }
+
+    switch (rng() % 20) {
+    case 0:
+    case 1:
+      res += "  ld" + reg() + " " + value() + "\n";
+      break;
+    case 2:
+      res += "  str" + reg() + " " + std::to_string(rng() % 16) + "\n";
+      break;
+    case 3:
+      res += "  out" + reg() + "\n";
+      break;
+    case 4:
+      res += "  add" + reg() + reg() + reg() + "\n";
+      break;
+    case 5:
+      res += "  sub" + reg() + reg() + reg() + "\n";
+      break;
+    case 6:
+      res += "  mul" + reg() + reg() + reg() + "\n";
+      break;
+    case 7:
+      // Divisions by zero make the program fail, which must be kept.
+      if (rng() % 4 == 0)
+        res += "  div" + reg() + reg() + reg() + "\n";
+      break;
+    case 8:
+      res += "  inc" + reg() + "\n";
+      break;
+    case 9:
+      res += "  dec" + reg() + "\n";
+      break;
+    case 10:
+      res += "  br" + forward() + "\n";
+      break;
+    case 11: {
+      static constexpr char const *conditions[] = {"be", "bn", "bg",
+                                                   "bs", "bge", "bse"};
+      res += "  " + std::string{conditions[rng() % 6]} + forward() + reg() +
+             reg() + "\n";
+      break;
+    }
+    case 12: {
+      // Diamond: a branch over a branch, as left by naive code generation.
+      auto taken = "d" + std::to_string(next_local++);
+      auto join = "d" + std::to_string(next_local++);
+      res += "  bg " + taken + reg() + reg() + "\n  br " + join + "\n" +
+             taken + "\n  out" + reg() + "\n" + join + "\n";
+      break;
+    }
+    case 13: {
+      // Branch to the next instruction.
+      auto next = "d" + std::to_string(next_local++);
+      res += "  br " + next + "\n" + next + "\n";
+      break;
+    }
+    case 14: {
+      auto r = reg();
+      res += "  inc" + r + "\n  dec" + r + "\n";
+      break;
+    }
+    default:
+      res += "  ld" + reg() + " " + std::to_string(rng() % 3) + "\n";
+      break;
+    }
+  }
+
+  while (next_label < label_count)
+    res += "l" + std::to_string(next_label++) + "\n";
+
+  if (looping)
+    res += "  dec" + std::string{COUNTER} + "\n  bn top" + COUNTER + ZERO +
+           "\n";
+
+  res += "end\n";
+  for (int i = 0; i < 10; ++i)
+    res += "  out r" + std::to_string(i) + "\n";
+
+  return res;
+}
+
+fnt::DenseProgram compile_text(std::string const &text) {
+  auto stream = std::istringstream{text};
+
+  return fnt::DenseProgram::from_program_repr(
+      fnt::ProgramRepr::from_stream(stream));
+}
+
+bool same_program(fnt::DenseProgram const &lhs, fnt::DenseProgram const &rhs) {
+  if (lhs.size() != rhs.size() or lhs.label_count() != rhs.label_count())
+    return false;
+
+  for (std::size_t i = 0; i < lhs.size(); ++i)
+    if (lhs[i].opcode != rhs[i].opcode or lhs[i].a != rhs[i].a or
+        lhs[i].b != rhs[i].b or lhs[i].c != rhs[i].c or
+        lhs[i].imm != rhs[i].imm)
+      return false;
+
+  for (std::uint32_t id = 0; id < lhs.label_count(); ++id)
+    if (lhs.label_name(id) != rhs.label_name(id) or
+        lhs.get_symbols().target(id) != rhs.get_symbols().target(id))
+      return false;
+
+  return true;
+}
+
+Outcome run_program(fnt::DenseProgram const &program) {
+  auto res = Outcome{};
+  auto state = vm::State{};
+
+  try {
+    vm::run_threaded(vm::Executable::lower(program), state);
+  } catch (std::exception const &) {
+    res.failed = true;
+  }
+  res.output = std::move(state.output);
+
+  return res;
+}
+
+void report(std::string_view test, std::string_view message,
+            std::string_view program) {
+  std::cerr << test << ": " << message << "\n";
+  if (not program.empty())
+    std::cerr << program << "\n";
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "tests.hpp"
+#include <algorithm>
+#include <exception>
+#include <front/incremental.hpp>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "incremental";
+
+constexpr std::size_t EDITS_PER_PROGRAM = 20;
+
+// Renamings of one label, which must not leave an id behind each time.
+constexpr std::size_t RENAMINGS = 1000;
+
+using Program = fnt::IncrementalProgram;
+
+/**
+ * Describes an instruction with label names instead of label ids, since two
+ * programs number their labels in their own order.
+ */
+template <typename F>
+std::string describe(fnt::DenseInstr const &instr, F &&label_name) {
+  auto res = std::to_string(static_cast<int>(instr.opcode)) + " " +
+             std::to_string(instr.a) + " " + std::to_string(instr.b) + " " +
+             std::to_string(instr.c) + " ";
+
+  if (fnt::is_branch(instr.opcode) or instr.opcode == fnt::Opcode::LABEL)
+    res += label_name(instr.label());
+  else
+    res += std::to_string(instr.imm);
+
+  return res + "\n";
+}
+
+std::string describe(Program const &program, Program::Line const &line) {
+  auto res = std::string{};
+
+  for (auto const &instr : line.instructions)
+    res += describe(instr->lower(), [&](std::uint32_t id) {
+      return program.get_symbols().name(id);
+    });
+
+  return res;
+}
+
+std::string compare_instructions(Program const &edited,
+                                 fnt::DenseProgram const &whole) {
+  auto instructions = std::string{};
+  for (auto const &line : edited.get_lines())
+    instructions += describe(edited, *line);
+
+  auto expected = std::string{};
+  for (auto const &instr : whole)
+    expected += describe(
+        instr, [&](std::uint32_t id) { return whole.label_name(id); });
+
+  if (instructions != expected)
+    return "the whole program parser builds other instructions";
+
+  return {};
+}
+
+std::size_t live_labels(fnt::SymbolTable const &symbols) {
+  std::size_t res = 0;
+
+  for (std::uint32_t id = 0; id < symbols.size(); ++id)
+    if (symbols.find(symbols.name(id)) == id)
+      ++res;
+
+  return res;
+}
+
+/**
+ * Compares an edited program to the same text parsed from scratch: line by
+ * line, the labels each line defines, and the labels still named. When the
+ * whole program parser accepts the text too, it must build the same
+ * instructions.
+ */
+std::string compare(Program const &edited) {
+  auto text = edited.get_text();
+  auto parsed = Program::from_text(text);
+  auto const &lines = edited.get_lines();
+  auto const &expected = parsed.get_lines();
+
+  if (lines.size() != expected.size())
+    return "line counts differ";
+
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    if (lines[i]->number != i)
+      return "line " + std::to_string(i) + " is misnumbered";
+
+    if (lines[i]->text != expected[i]->text or
+        lines[i]->error != expected[i]->error or
+        describe(edited, *lines[i]) != describe(parsed, *expected[i]))
+      return "line " + std::to_string(i) + " differs";
+  }
+
+  auto const &symbols = parsed.get_symbols();
+  for (std::uint32_t id = 0; id < symbols.size(); ++id) {
+    auto edited_id = edited.get_symbols().find(symbols.name(id));
+    if (not edited_id)
+      return "label " + std::string{symbols.name(id)} + " is missing";
+
+    auto line = edited.get_label_line(*edited_id);
+    auto expected_line = parsed.get_label_line(id);
+    if ((line == nullptr) != (expected_line == nullptr) or
+        (line != nullptr and line->number != expected_line->number))
+      return "label " + std::string{symbols.name(id)} + " is defined elsewhere";
+  }
+
+  if (live_labels(edited.get_symbols()) != live_labels(symbols))
+    return "labels no line names are kept";
+
+  if (edited.has_errors())
+    return {};
+
+  try {
+    return compare_instructions(edited, compile_text(text));
+  } catch (std::exception const &) {
+    // Undefined labels are only found by the whole program parser.
+    return {};
+  }
+}
+
+std::size_t offset_of(Program const &program, std::size_t line,
+                      std::size_t column) {
+  std::size_t res = column;
+
+  for (std::size_t i = 0; i < line; ++i)
+    res += program.get_lines()[i]->text.size() + 1;
+
+  return res;
+}
+
+/**
+ * Draws an edit among line replacements and insertions, multi-line deletions,
+ * splices of text with line breaks in the middle of a line, and definitions of
+ * labels already defined, either before or after their definition.
+ */
+std::string random_edit(Program &program,
+                        std::vector<std::string> const &pool,
+                        std::mt19937_64 &rng) {
+  // Some of them give a label line a second label.
+  static constexpr std::string_view splices[] = {
+      "\n",      "l1",    " r3",           "\nl0\n",  "  br l2\n",
+      " l3",    " end l1", "d0\n  out r1", "x\nend", "top d1\n",
+  };
+
+  auto const &lines = program.get_lines();
+  auto size = program.get_text().size();
+  auto line = rng() % lines.size();
+  auto const &text = lines[line]->text;
+  auto column = rng() % (text.size() + 1);
+  auto edit = fnt::TextEdit{line, 0, 0, {}};
+  auto inserted = pool[rng() % pool.size()];
+
+  switch (rng() % 6) {
+  case 0:
+    edit.length = text.size();
+    edit.text = inserted;
+    break;
+  case 1:
+    inserted += "\n";
+    edit.text = inserted;
+    break;
+  case 2: {
+    edit.column = column;
+    auto offset = offset_of(program, line, column);
+    edit.length = rng() % (std::min<std::size_t>(size - offset, 40) + 1);
+    break;
+  }
+  case 3: {
+    edit.column = column;
+    edit.length = rng() % (text.size() - column + 1);
+    edit.text = splices[rng() % std::size(splices)];
+    break;
+  }
+  case 4:
+    // Labels start their line, and the pool holds copies of all of them.
+    inserted = pool[rng() % pool.size()];
+    while (inserted.empty() or inserted.front() == ' ')
+      inserted = pool[rng() % pool.size()];
+    inserted += "\n";
+    edit.text = inserted;
+    break;
+  default:
+    if (line + 1 < lines.size())
+      edit.length = text.size() + 1;
+    else
+      edit.length = text.size();
+    break;
+  }
+
+  auto res = program.get_text();
+  program.edit(edit);
+
+  return res;
+}
+
+std::vector<std::string> split(std::string const &text) {
+  auto res = std::vector<std::string>{};
+  std::size_t begin = 0;
+
+  for (auto end = text.find('\n'); end != std::string::npos;
+       end = text.find('\n', begin)) {
+    res.push_back(text.substr(begin, end - begin));
+    begin = end + 1;
+  }
+
+  res.push_back(text.substr(begin));
+
+  return res;
+}
+
+std::size_t check_renamings() {
+  auto program = Program::from_text("a\n  br a\n");
+  auto initial = program.get_symbols().size();
+
+  for (std::size_t i = 0; i < RENAMINGS; ++i) {
+    auto name = "a" + std::to_string(i);
+    program.edit({0, 0, program.get_lines()[0]->text.size(), name});
+    program.edit({1, 5, program.get_lines()[1]->text.size() - 5, name});
+  }
+
+  if (program.get_symbols().size() > initial + 1) {
+    report(NAME,
+           "renaming a label grows the symbols to " +
+               std::to_string(program.get_symbols().size()),
+           program.get_text());
+    return 1;
+  }
+
+  if (auto failure = compare(program); not failure.empty()) {
+    report(NAME, failure, program.get_text());
+    return 1;
+  }
+
+  return 0;
+}
+
+} // namespace
+
+std::size_t test_incremental(std::size_t count) {
+  std::size_t res = check_renamings();
+  auto rng = std::mt19937_64{count};
+
+  for (std::size_t seed = 0; seed * EDITS_PER_PROGRAM < count; ++seed) {
+    auto text = random_program(seed, 20);
+    auto pool = split(text);
+    auto program = Program::from_text(text);
+
+    for (std::size_t i = 0; i < EDITS_PER_PROGRAM; ++i) {
+      auto before = random_edit(program, pool, rng);
+
+      if (auto failure = compare(program); not failure.empty()) {
+        report(NAME, failure + ", after editing", before);
+        report(NAME, "into", program.get_text());
+        ++res;
+        break;
+      }
+    }
+  }
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
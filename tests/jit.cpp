@@ -0,0 +1,141 @@
+#include "tests.hpp"
+#include <back/jit.hpp>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <string>
+#include <vm/vm.hpp>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "jit";
+
+constexpr std::int32_t EDGE_VALUES[] = {
+    std::numeric_limits<std::int32_t>::min(),
+    -1,
+    0,
+    1,
+    std::numeric_limits<std::int32_t>::max(),
+};
+
+constexpr std::string_view CONDITIONS[] = {"be", "bn", "bg",
+                                           "bs", "bge", "bse"};
+
+/**
+ * Final state of a run: the observable outcome, and the registers and the
+ * memory, which the JIT shares with the interpreters.
+ */
+struct Run {
+  Outcome outcome;
+  vm::State state;
+};
+
+// Same as vm::run, which loses the state when the program fails.
+Run run_vm(fnt::DenseProgram const &program) {
+  auto executable = vm::Executable::lower(program);
+  auto res = Run{{}, vm::State{executable.memory_size()}};
+
+  try {
+    vm::run_threaded(executable, res.state);
+  } catch (std::exception const &) {
+    res.outcome.failed = true;
+  }
+  res.outcome.output = res.state.output;
+
+  return res;
+}
+
+Run run_jit(fnt::DenseProgram const &program) {
+  auto jit = bck::JitProgram::compile(program);
+  auto res = Run{{}, vm::State{}};
+
+  try {
+    jit.run(res.state);
+  } catch (std::exception const &) {
+    res.outcome.failed = true;
+  }
+  res.outcome.output = res.state.output;
+
+  return res;
+}
+
+std::size_t check(std::string const &text) {
+  auto program = compile_text(text);
+  auto expected = run_vm(program);
+  auto actual = run_jit(program);
+
+  if (actual.outcome != expected.outcome) {
+    report(NAME,
+           "outputs differ: " + actual.outcome.output + " instead of " +
+               expected.outcome.output,
+           text);
+    return 1;
+  }
+
+  if (actual.state.registers != expected.state.registers or
+      actual.state.memory != expected.state.memory) {
+    report(NAME, "final states differ", text);
+    return 1;
+  }
+
+  return 0;
+}
+
+// Literals are never negative, so some values are computed.
+std::string load(std::string_view reg, std::int32_t value) {
+  auto r = std::string{reg};
+
+  if (value == std::numeric_limits<std::int32_t>::min())
+    return "  ld " + r + " 2147483647\n  inc " + r + "\n";
+
+  if (value < 0)
+    return "  ld " + r + " " + std::to_string(-value) + "\n  sub " + r +
+           " r0 " + r + "\n";
+
+  return "  ld " + r + " " + std::to_string(value) + "\n";
+}
+
+/**
+ * Checks divisions, by zero and of the smallest integer by -1 included, and
+ * every branch condition, on every pair of edge values.
+ */
+std::size_t check_edges() {
+  std::size_t res = 0;
+
+  for (auto lhs : EDGE_VALUES) {
+    for (auto rhs : EDGE_VALUES) {
+      auto operands = load("r1", lhs) + load("r2", rhs);
+
+      res += check(operands + "  out r1\n  div r3 r1 r2\n  out r3\n");
+
+      for (auto condition : CONDITIONS)
+        res += check(operands + "  " + std::string{condition} +
+                     " taken r1 r2\n  ld r3 1\n  br end\ntaken\n  ld r3 2\n"
+                     "end\n  out r3\n");
+    }
+  }
+
+  return res;
+}
+
+} // namespace
+
+std::size_t test_jit(std::size_t count) {
+  if (not bck::jit_available())
+    return 0;
+
+  std::size_t res = check_edges();
+
+  for (std::size_t seed = 0; seed < count; ++seed)
+    res += check(random_program(seed));
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
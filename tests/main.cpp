@@ -1,12 +1,67 @@
-#include "front/repr.hpp"
-#include <front/source.hpp>
-#include <front/token.hpp>
+#include "tests.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <string_view>
 
-int main() {
-  using namespace cmp::fnt;
+namespace {
 
-  auto source = TextSource::from_file("/home/daimyo/dev/cmp/res/program.asm");
-  auto tokens = TokenTable::from_text_source(source);
-  auto repr = ProgramRepr::from_token_table(tokens);
+using namespace cmp;
+
+// Number of random cases of each test, which a factor given on the command
+// line multiplies.
+constexpr std::size_t DEFAULT_CASES = 10000;
+
+struct Test {
+  std::string_view name;
+  std::function<std::size_t(std::size_t)> run;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t scale = 1;
+
+  try {
+    if (argc == 2)
+      scale = std::stoull(argv[1]);
+  } catch (std::exception const &) {
+    scale = 0;
+  }
+
+  if (argc > 2 or scale == 0) {
+    std::cerr << "usage: tests [scale]\n";
+    return EXIT_FAILURE;
+  }
+
+  Test const tests[] = {
+      {"optimizer", tests::test_optimizer},
+      {"word splitters", tests::test_word_splitters},
+      {"diagnostics", tests::test_diagnostics},
+      {"incremental", tests::test_incremental},
+      {"jit", tests::test_jit},
+      {"assembly", tests::test_assembly},
+      {"batch", tests::test_batch},
+      {"cache", tests::test_cache},
+  };
+
+  std::size_t failures = 0;
+  for (auto const &test : tests) {
+    std::size_t count = 0;
+
+    try {
+      count = test.run(DEFAULT_CASES * scale);
+    } catch (std::exception const &e) {
+      tests::report(test.name, e.what());
+      count = 1;
+    }
+
+    std::cout << test.name << ": " << (count == 0 ? "ok" : "FAILED") << "\n";
+    failures += count;
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "tests.hpp"
+#include <opt/constant.hpp>
+#include <opt/dead.hpp>
+#include <opt/peephole.hpp>
+#include <string>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "optimizer";
+
+/**
+ * Checks one program: each pass alone, then all of them chained, must behave
+ * as the original program.
+ */
+std::size_t check_program(std::string const &text) {
+  std::size_t res = 0;
+  auto program = compile_text(text);
+  auto expected = run_program(program);
+
+  auto check = [&](std::string_view pass, fnt::DenseProgram const &optimized) {
+    if (run_program(optimized) == expected)
+      return;
+
+    report(NAME, std::string{pass} + " changed the behavior of", text);
+    ++res;
+  };
+
+  auto constant_stats = opt::ConstantStats{};
+  auto constant = opt::propagate_constants(program, constant_stats);
+  check("constant propagation", constant);
+  if (constant_stats.instructions_before != program.size() or
+      constant_stats.instructions_after != constant.size()) {
+    report(NAME, "constant propagation miscounted", text);
+    ++res;
+  }
+
+  auto dead_stats = opt::DeadCodeStats{};
+  auto dead = opt::eliminate_dead_code(program, dead_stats);
+  check("dead code elimination", dead);
+  if (dead_stats.instructions_after != dead.size() or
+      dead_stats.removed != program.size() - dead.size()) {
+    report(NAME, "dead code elimination miscounted", text);
+    ++res;
+  }
+  if (opt::eliminate_dead_code(dead, dead_stats); dead_stats.removed != 0) {
+    report(NAME, "dead code elimination did not reach a fixpoint", text);
+    ++res;
+  }
+
+  auto peephole_stats = opt::PeepholeStats{};
+  auto peephole =
+      opt::run_peephole(program, opt::default_rules(), peephole_stats);
+  check("peephole", peephole);
+  if (peephole_stats.instructions_after != peephole.size()) {
+    report(NAME, "peephole miscounted", text);
+    ++res;
+  }
+  opt::run_peephole(peephole, opt::default_rules(), peephole_stats);
+  for (auto const &rule : peephole_stats.fired) {
+    if (rule.count != 0) {
+      report(NAME,
+             "peephole did not reach a fixpoint: " + std::string{rule.name},
+             text);
+      ++res;
+    }
+  }
+
+  check("the pipeline",
+        opt::run_peephole(opt::eliminate_dead_code(constant)));
+
+  return res;
+}
+
+} // namespace
+
+std::size_t test_optimizer(std::size_t count) {
+  std::size_t res = 0;
+
+  for (std::size_t seed = 0; seed < count; ++seed)
+    res += check_program(random_program(seed));
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
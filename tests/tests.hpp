@@ -0,0 +1,165 @@
+/**
+ * @file tests.hpp
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <front/ir.hpp>
+#include <string>
+#include <string_view>
+
+namespace cmp {
+
+namespace tests {
+
+/**
+ * Generates a random program which always ends. Branches only go forward, to
+ * labels defined later or to the end of the program. Every other program is
+ * wrapped into a loop counted down from a small value, whose counter the body
+ * never writes. The program outputs every register before ending, so that
+ * their final values are observable. The same seed always gives the same
+ * program.
+ *
+ * @param seed The seed of the generator
+ * @param instr_count The number of instructions of the body, labels included
+ * @return std::string The program text
+ */
+std::string random_program(std::uint64_t seed, std::size_t instr_count = 60);
+
+/**
+ * Compiles a program text into a dense program.
+ *
+ * @param text The program text
+ * @return fnt::DenseProgram
+ */
+fnt::DenseProgram compile_text(std::string const &text);
+
+/**
+ * Checks if two programs have the same instructions, and the same labels with
+ * the same ids and targets.
+ *
+ * @param lhs The first program
+ * @param rhs The second program
+ * @return true if they are the same, else, false
+ */
+bool same_program(fnt::DenseProgram const &lhs, fnt::DenseProgram const &rhs);
+
+/**
+ * Observable behavior of a program: what it outputs, and whether it fails.
+ */
+struct Outcome {
+  std::string output;
+  bool failed = false;
+
+  bool operator==(Outcome const &) const = default;
+};
+
+/**
+ * Runs a program in the VM from a fresh state.
+ *
+ * @param program The program
+ * @return Outcome
+ */
+Outcome run_program(fnt::DenseProgram const &program);
+
+/**
+ * Prints a failure of a test.
+ *
+ * @param test The name of the test
+ * @param message What went wrong
+ * @param program The program text it went wrong with, if any
+ */
+void report(std::string_view test, std::string_view message,
+            std::string_view program = {});
+
+/**
+ * Checks that the optimizer passes, alone and chained, never change what a
+ * random program outputs nor whether it fails, and that their statistics and
+ * fixpoints hold.
+ *
+ * @param count The number of random programs
+ * @return std::size_t The number of failures
+ */
+std::size_t test_optimizer(std::size_t count);
+
+/**
+ * Checks that every word splitter the processor supports extracts exactly the
+ * same words as the scalar one, from random ranges of random texts.
+ *
+ * @param count The number of random ranges
+ * @return std::size_t The number of failures
+ */
+std::size_t test_word_splitters(std::size_t count);
+
+/**
+ * Checks the diagnostics of a set of invalid programs, then that validation
+ * and the throwing path agree on randomly damaged programs: both accept or
+ * reject each of them, build the same program when they accept it, and the
+ * diagnostics are in order and located at their token. Building dense
+ * instructions directly must also agree with lowering the representation,
+ * errors included.
+ *
+ * @param count The number of damaged programs
+ * @return std::size_t The number of failures
+ */
+std::size_t test_diagnostics(std::size_t count);
+
+/**
+ * Checks that a program edited incrementally, through line replacements,
+ * multi-line deletions, splices of several lines and definitions of labels
+ * already defined, always matches its text parsed from scratch, and that
+ * renaming a label does not leave its former id behind.
+ *
+ * @param count The number of edits
+ * @return std::size_t The number of failures
+ */
+std::size_t test_incremental(std::size_t count);
+
+/**
+ * Checks that programs compiled by the baseline JIT output the same, fail the
+ * same and leave the same registers and memory as in the VM: random programs,
+ * then divisions and every branch condition on edge values. Nothing is checked
+ * where the JIT is not available.
+ *
+ * @param count The number of random programs
+ * @return std::size_t The number of failures
+ */
+std::size_t test_jit(std::size_t count);
+
+/**
+ * Checks that programs emitted as assembly, then assembled, linked and run,
+ * output the same and fail the same as in the VM: every branch condition and
+ * divisions on edge values, then one random program per hundred cases. Nothing
+ * is checked without a C compiler driver to build them.
+ *
+ * @param count The number of cases
+ * @return std::size_t The number of failures
+ */
+std::size_t test_assembly(std::size_t count);
+
+/**
+ * Checks that a batch collects the sources of a directory tree, compiles them
+ * into objects mirroring the tree, whatever the number of threads, and
+ * reports the invalid ones. Then checks that random programs written as
+ * objects map back into the same programs.
+ *
+ * @param count The number of cases, one program written per hundred
+ * @return std::size_t The number of failures
+ */
+std::size_t test_batch(std::size_t count);
+
+/**
+ * Checks that batches compiled through a cache fill it, then hit it, compile
+ * again the sources which changed, replace corrupted entries and evict entries
+ * over the maximum size, always writing the right objects.
+ *
+ * @param count The number of cases, one source per thousand
+ * @return std::size_t The number of failures
+ */
+std::size_t test_cache(std::size_t count);
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
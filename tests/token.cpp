@@ -0,0 +1,112 @@
+#include "tests.hpp"
+#include <front/token.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cmp {
+
+namespace tests {
+
+namespace {
+
+constexpr std::string_view NAME = "word splitters";
+
+constexpr std::size_t MAX_TEXT_SIZE = 300;
+
+constexpr fnt::detail::WordSplitter SPLITTERS[] = {
+    fnt::detail::WordSplitter::SCALAR,
+    fnt::detail::WordSplitter::SSE2,
+    fnt::detail::WordSplitter::AVX2,
+};
+
+bool is_white(char c) { return static_cast<unsigned char>(c) <= ' '; }
+
+/**
+ * Draws a byte, mostly among white characters and letters, but also among
+ * the bytes on each side of the white character limit.
+ */
+char random_byte(std::mt19937_64 &rng) {
+  static constexpr std::string_view common = " \t\n\r abr0123456789ldmul";
+
+  switch (rng() % 8) {
+  case 0:
+    return static_cast<char>(rng() % 256);
+  case 1:
+    return static_cast<char>(' ' + rng() % 2);
+  default:
+    return common[rng() % common.size()];
+  }
+}
+
+std::string describe(std::string_view text, std::size_t begin,
+                     std::size_t end) {
+  auto res = std::to_string(text.size()) + " bytes, range [" +
+             std::to_string(begin) + ", " + std::to_string(end) + "):";
+
+  for (unsigned char c : text)
+    res += " " + std::to_string(c);
+
+  return res;
+}
+
+bool same_words(fnt::TokenTable::token_type const &lhs,
+                fnt::TokenTable::token_type const &rhs) {
+  if (lhs.size() != rhs.size())
+    return false;
+
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    if (lhs.kind(i) != rhs.kind(i) or lhs.offset(i) != rhs.offset(i) or
+        lhs.word(i) != rhs.word(i))
+      return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+std::size_t test_word_splitters(std::size_t count) {
+  std::size_t res = 0;
+  auto rng = std::mt19937_64{count};
+
+  for (std::size_t i = 0; i < count; ++i) {
+    // Exactly sized, so that reading past the text is caught by sanitizers.
+    auto buffer = std::vector<char>(rng() % MAX_TEXT_SIZE);
+    for (auto &c : buffer)
+      c = random_byte(rng);
+    auto text = std::string_view{buffer.data(), buffer.size()};
+
+    // The range may neither start nor end in the middle of a word.
+    auto begin = text.empty() ? 0 : rng() % (text.size() + 1);
+    while (begin > 0 and not is_white(text[begin - 1]))
+      --begin;
+    auto end = begin + rng() % (text.size() - begin + 1);
+    while (end < text.size() and not is_white(text[end]))
+      ++end;
+
+    auto expected = fnt::TokenTable::token_type{text};
+    fnt::detail::extract_words(text, begin, end, expected,
+                               fnt::detail::WordSplitter::SCALAR);
+
+    for (auto splitter : SPLITTERS) {
+      if (not fnt::detail::is_supported(splitter))
+        continue;
+
+      auto words = fnt::TokenTable::token_type{text};
+      fnt::detail::extract_words(text, begin, end, words, splitter);
+      if (not same_words(words, expected)) {
+        report(NAME,
+               "splitter " + std::to_string(static_cast<int>(splitter)) +
+                   " differs on " + describe(text, begin, end));
+        ++res;
+      }
+    }
+  }
+
+  return res;
+}
+
+} // namespace tests
+
+} // namespace cmp
\ No newline at end of file
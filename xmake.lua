@@ -3,13 +3,51 @@ add_rules("mode.debug", "mode.release")
 set_toolchains("gcc")
 set_languages("cxx20")
 
+option("superinstructions")
+  set_default("")
+  set_showmenu(true)
+  set_description("Superinstructions enabled by default in the VM, as the mask",
+                  "selected by the profiler (e.g. 0x2)")
+option_end()
+
+option("metrics")
+  set_default(false)
+  set_showmenu(true)
+  set_description("Record front-end phase times, counts and allocations")
+option_end()
+
 
 target("tests")
   set_kind("binary")
   add_files("tests/*.cpp")
   add_includedirs("lib/")
 
-  add_deps("front")
+  add_deps("front", "back", "vm", "opt", "driver")
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
+
+
+target("bench")
+  set_kind("binary")
+  add_files("bench/*.cpp", "cli/alloc.cpp")
+  add_includedirs("lib/")
+  add_defines("CMP_COUNT_ALLOCATIONS")
+
+  add_deps("front", "back", "vm")
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
+
+
+target("cmpc")
+  set_kind("binary")
+  add_files("cli/*.cpp")
+  add_includedirs("lib/")
+
+  add_deps("driver")
 
   if is_mode("debug") then
     add_defines("DEBUG")
@@ -20,8 +58,66 @@ target("front")
   set_kind("static")
   add_files("src/front/*.cpp")
   add_includedirs("lib/")
+  add_syslinks("pthread", {public = true})
+
+  if has_config("metrics") then
+    add_defines("CMP_METRICS", {public = true})
+  end
 
   if is_mode("debug") then 
     add_defines("DEBUG")
   end
 
+
+target("back")
+  set_kind("static")
+  add_files("src/back/*.cpp")
+  add_includedirs("lib/")
+
+  add_deps("front", "vm")
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
+
+
+target("vm")
+  set_kind("static")
+  add_files("src/vm/*.cpp")
+  add_includedirs("lib/")
+
+  add_deps("front")
+
+  local superinstructions = get_config("superinstructions")
+  if superinstructions and superinstructions ~= "" then
+    add_defines("CMP_SUPERINSTRUCTIONS=" .. superinstructions)
+  end
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
+
+
+
+target("opt")
+  set_kind("static")
+  add_files("src/opt/*.cpp")
+  add_includedirs("lib/")
+
+  add_deps("front", "vm")
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
+
+
+target("driver")
+  set_kind("static")
+  add_files("src/driver/*.cpp")
+  add_includedirs("lib/")
+
+  add_deps("front", "back")
+
+  if is_mode("debug") then
+    add_defines("DEBUG")
+  end
\ No newline at end of file